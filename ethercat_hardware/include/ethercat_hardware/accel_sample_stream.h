@@ -0,0 +1,86 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__ACCEL_SAMPLE_STREAM_H
+#define ETHERCAT_HARDWARE__ACCEL_SAMPLE_STREAM_H
+
+#include "ethercat_hardware/sample_stream.h"
+#include "ethercat_hardware/RawAccelData.h"
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Packed accelerometer sample, as sent by WG06
+ *
+ * Bits 0-9, 10-19, 20-29 hold signed 10bit X, Y, Z values. 
+ * Bits 30-31 hold range setting that sample was taken with.
+ */
+struct AccelSample
+{
+  uint32_t raw_;
+
+  unsigned range() const {return (raw_ >> 30) & 0x3;}
+
+  //! Convert sample to m/s^2
+  void decode(double &x, double &y, double &z) const
+  {
+    double scale = SCALE[range()];
+    x = scale * signExtend(raw_ >>  0);
+    y = scale * signExtend(raw_ >> 10);
+    z = scale * signExtend(raw_ >> 20);
+  }
+
+  //! Sign extend 10bit value held in lower bits
+  static int signExtend(uint32_t value) {return int((value & 0x3ff) ^ 0x200) - 0x200;}
+
+  //! m/s^2 per count, for each range setting
+  static const double SCALE[4];
+};
+
+
+//! Publishes every accelerometer sample in RawAccelData batches
+struct AccelSampleStreamTraits
+{
+  typedef AccelSample Sample;
+  typedef ethercat_hardware::RawAccelData Message;
+  static void appendSample(Message &msg, uint64_t sample_count, const Sample &sample);
+  static void finishBatch(Message &msg, uint64_t overflow_count);
+};
+
+typedef SampleStream<AccelSampleStreamTraits> AccelSampleStream;
+
+}; // end namespace ethercat_hardware
+
+#endif //ETHERCAT_HARDWARE__ACCEL_SAMPLE_STREAM_H
@@ -0,0 +1,136 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__CYCLE_DEADLINE_MONITOR_H
+#define ETHERCAT_HARDWARE__CYCLE_DEADLINE_MONITOR_H
+
+#include <boost/utility.hpp>
+#include <boost/atomic.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Checks each realtime cycle against deadlines, and keeps a flight recorder of recent cycles.
+ *
+ * Every phase of EthercatHardware::update(), the whole update, and the period between 
+ * starts of consecutive updates each have a deadline.  Overruns are counted, and the 
+ * longest overrun and longest streak of consecutive overruns are tracked.
+ *
+ * Timing of recent cycles is kept in a ring buffer.  When an overrun streak or a single 
+ * overrun crosses its threshold, recorder keeps going for a few more cycles, then freezes, 
+ * so captured history shows cycles before and after the spike.  Non-realtime thread takes 
+ * frozen capture with takeCapture(), which re-arms recorder.
+ */
+class CycleDeadlineMonitor : private boost::noncopyable
+{
+public:
+  enum Phase {PACK, TXANDRX, UNPACK, PUBLISH, UPDATE, PERIOD, NUM_PHASES};
+  static const char *phaseName(unsigned phase);
+
+  struct PhaseStats
+  {
+    double deadline_;          //!< Seconds, zero if phase is not checked
+    uint64_t overruns_;
+    double longest_overrun_;   //!< Longest time past deadline, in seconds
+    unsigned streak_;          //!< Current number of consecutive overruns
+    unsigned longest_streak_;
+  };
+
+  struct Stats
+  {
+    PhaseStats phases_[NUM_PHASES];
+    uint64_t cycles_;
+    unsigned captures_;        //!< Number of times recorder was frozen
+  };
+
+  struct CycleRecord
+  {
+    uint64_t cycle_;
+    double start_;                 //!< Start of update, in seconds
+    double times_[NUM_PHASES];     //!< Duration of each phase, in seconds
+    unsigned overrun_mask_;        //!< Bit N set if phase N overran its deadline
+  };
+
+  explicit CycleDeadlineMonitor(unsigned history = 500);
+
+  void setDeadline(unsigned phase, double deadline);
+  /*!
+   * \brief Sets when recorder freezes
+   * \param streak        freeze after this many consecutive overruns of any phase, zero to disable
+   * \param overrun       freeze after single overrun longer than this many seconds, zero to disable
+   * \param post_cycles   number of cycles to keep recording after trigger
+   */
+  void setFreezeThresholds(unsigned streak, double overrun, unsigned post_cycles);
+
+  /*!
+   * \brief Checks one cycle against deadlines.  Called from realtime loop, never blocks or allocates.
+   * \param start   time update started, in seconds
+   * \param times   duration of PACK, TXANDRX, UNPACK, and PUBLISH phases, in seconds. 
+   *                UPDATE and PERIOD are computed from these and start.
+   */
+  void record(double start, const double times[NUM_PHASES]);
+
+  //! Returns copy of statistics.  Only call from thread that calls record().
+  const Stats &stats() const {return stats_;}
+
+  /*!
+   * \brief Takes frozen capture and re-arms recorder.  Safe to call from non-realtime thread.
+   * \param records  set to captured cycles, oldest first
+   * \param reason   set to description of trigger
+   * \return false if there is no frozen capture
+   */
+  bool takeCapture(std::vector<CycleRecord> &records, std::string &reason);
+
+protected:
+  enum {RECORDING, TRIGGERED, FROZEN};
+  boost::atomic<int> state_;
+  std::vector<CycleRecord> history_;
+  unsigned next_;              //!< Next slot of history_ to write
+  unsigned filled_;            //!< Number of valid slots
+  unsigned post_remaining_;    //!< Cycles left to record after trigger
+  unsigned freeze_streak_;
+  double freeze_overrun_;
+  unsigned post_cycles_;
+  char reason_[128];
+  double last_start_;
+  Stats stats_;
+};
+
+}
+
+#endif /* ETHERCAT_HARDWARE__CYCLE_DEADLINE_MONITOR_H */
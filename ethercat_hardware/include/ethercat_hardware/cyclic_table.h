@@ -0,0 +1,108 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__CYCLIC_TABLE_H
+#define ETHERCAT_HARDWARE__CYCLIC_TABLE_H
+
+#include <vector>
+
+class EthercatDevice;
+class WG05;
+class WG06;
+class WG021;
+class WG014;
+class EK1122;
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Device of cyclic table, with everything needed to find its process data.
+ */
+template <class Device>
+struct CyclicEntry
+{
+  Device *device_;
+  unsigned slave_;    //!< Index of device in EthercatHardware::slaves_, used to stagger release from halt
+  unsigned offset_;   //!< Offset of device command and status in process data buffer
+  unsigned size_;     //!< Size of device command plus status
+};
+
+
+/*!
+ * \brief Packs commands and unpacks status of one exchange group, without virtual calls for known devices.
+ *
+ * Devices are sorted into one list per device type when table is built.  
+ * For devices whose dynamic type is exactly one of the known types, packCommand() and unpackState() 
+ * are called through a qualified name, so compiler calls (or inlines) them directly.  
+ * All other devices, including plugins from other packages and classes derived from known 
+ * types, use normal virtual calls.
+ */
+class CyclicTable
+{
+public:
+  void clear();
+  void add(EthercatDevice *device, unsigned slave, unsigned offset);
+
+  /*!
+   * \brief Packs commands of all devices in table.
+   * Device is halted if halt is set, or while it is waiting to be released from halt after reset.
+   */
+  void packCommands(unsigned char *buffer, bool halt, bool reset, unsigned reset_state, unsigned cycles_per_halt_release);
+
+  /*!
+   * \brief Unpacks status of all devices in table
+   * \param keep_copy  if true, data of each device is also copied to prev_buffer, 
+   *                   for groups that are not exchanged every cycle
+   * \return false if any device reported an error
+   */
+  bool unpackStates(unsigned char *this_buffer, unsigned char *prev_buffer, bool keep_copy);
+
+  //! Number of devices that are called without virtual dispatch
+  unsigned numTyped() const;
+  //! Number of devices that use virtual dispatch
+  unsigned numGeneric() const {return generic_.size();}
+
+protected:
+  std::vector<CyclicEntry<WG05> > wg05_;
+  std::vector<CyclicEntry<WG06> > wg06_;
+  std::vector<CyclicEntry<WG021> > wg021_;
+  std::vector<CyclicEntry<WG014> > wg014_;
+  std::vector<CyclicEntry<EK1122> > ek1122_;
+  std::vector<CyclicEntry<EthercatDevice> > generic_;
+};
+
+}
+
+#endif /* ETHERCAT_HARDWARE__CYCLIC_TABLE_H */
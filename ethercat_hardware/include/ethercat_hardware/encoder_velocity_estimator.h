@@ -0,0 +1,97 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__ENCODER_VELOCITY_ESTIMATOR_H
+#define ETHERCAT_HARDWARE__ENCODER_VELOCITY_ESTIMATOR_H
+
+#include <stdint.h>
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Estimates encoder velocity from a short history of (count, timestamp) samples.
+ *
+ * Differentiating two consecutive samples gives velocity quantized to one count per cycle, 
+ * which is very coarse at low speed.  This estimator uses first-order adaptive windowing 
+ * (end-fit FOAW) : it takes the longest window of recent samples where a straight line 
+ * through the newest and oldest sample stays within noise band of every sample in between.
+ * At low speed the window grows and resolution improves, when velocity changes the window 
+ * shrinks and estimate stays responsive.  Velocity is then least-squares slope over window.
+ *
+ * History is a fixed ring buffer, so update() never allocates, and its cost is bounded 
+ * by MAX_SAMPLES^2/2 simple operations.
+ */
+class EncoderVelocityEstimator
+{
+public:
+  static const unsigned MAX_SAMPLES = 16;
+
+  /*!
+   * \param noise_band  allowed deviation of samples from fitted line, in encoder counts
+   * \param max_window  longest time span of window, in seconds
+   */
+  EncoderVelocityEstimator(double noise_band = 1.0, double max_window = 0.02);
+
+  void configure(double noise_band, double max_window);
+  //! Forgets history, for example after device reset
+  void reset();
+
+  /*!
+   * \brief Adds sample and returns new velocity estimate
+   * Sample with same timestamp as previous sample is ignored, timestamp going backwards restarts history.
+   * \param count      encoder count, may wrap around
+   * \param timestamp  device timestamp in microseconds, may wrap around
+   * \return           velocity in encoder counts per second
+   */
+  double update(int32_t count, uint32_t timestamp);
+
+  double velocity() const {return velocity_;}
+  //! Number of sample intervals used for last estimate
+  unsigned window() const {return window_;}
+
+protected:
+  int32_t counts_[MAX_SAMPLES];
+  uint32_t timestamps_[MAX_SAMPLES];
+  unsigned newest_;        //!< Index of newest sample
+  unsigned num_samples_;
+  double noise_band_;
+  double max_window_;
+  double velocity_;
+  unsigned window_;
+};
+
+}
+
+#endif /* ETHERCAT_HARDWARE__ENCODER_VELOCITY_ESTIMATOR_H */
@@ -113,6 +113,9 @@ public:
   // numPorts  Number of ports device is supposed to have.  4 is max, 1 is min.
   void publish(diagnostic_updater::DiagnosticStatusWrapper &d, unsigned numPorts=4) const;
 
+  //! True if device has been reset or power cycled, and no longer responds to its node address
+  bool resetDetected() const {return resetDetected_;}
+
 protected:
   void zeroTotals();
   void accumulate(const et1x00_error_counters &next, const et1x00_error_counters &prev);
@@ -142,7 +145,38 @@ public:
   EthercatDevice();
   virtual ~EthercatDevice();
 
+  /**
+   * \brief Reads device configuration over mailbox before initialize() is called.
+   * May be run concurrently for different devices, so it must not touch the hardware 
+   * interface or state shared between devices.  
+   * \return 0 for success, negative value for failure
+   */
+  virtual int preInitialize(bool allow_unprogrammed) {return 0;}
+
   virtual int initialize(pr2_hardware_interface::HardwareInterface *, bool allow_unprogrammed=0) = 0;
+
+  /**
+   * \brief Returns true if device needs different process data layout than the one set up by construct().
+   * Some devices only know which optional data regions to exchange after initialize() reads their 
+   * configuration.  When any device returns true, the chain is moved back to PREOP and construct() 
+   * is called again for every device so logical addresses stay contiguous.
+   */
+  virtual bool processDataLayoutChanged() const {return false;}
+
+  /*!
+   * \brief Returns code for optional data regions that are part of current process data layout.
+   * Saved in chain cache, so layout can be set up correctly by first construct() of next run.
+   */
+  virtual unsigned processDataLayout() const {return 0;}
+
+  /*!
+   * \brief Tells device which layout (from processDataLayout() of previous run) to expect, before construct() is called.
+   * If expectation turns out to be wrong, processDataLayoutChanged() reports it after initialize().
+   */
+  virtual void expectProcessDataLayout(unsigned layout) {}
+
+  //! Returns layout that construct() sets up when there is no expectation from previous run
+  virtual unsigned defaultProcessDataLayout() const {return 0;}
   
   /**
    * \param reset  when asserted this will clear diagnostic error conditions device safety disable
@@ -177,11 +211,23 @@ public:
 
   virtual void collectDiagnostics(EthercatCom *com);
 
+  /*!
+   * \brief Returns true if most recently collected diagnostics found device was reset.
+   */
+  bool resetDetected();
+
+  /*!
+   * \brief Restores device settings that were lost when device was reset.
+   * Called from non-realtime thread after reset device has been brought back to OP state.
+   * \return 0 for success, negative value for failure
+   */
+  virtual int reconfigure(EthercatCom *com) {return 0;}
+
   /** 
    * \brief Asks device to publish (motor) trace. Only works for devices that support it. 
    * \param reason Message to put in trace as reason. 
    * \param level Level to put in trace (aka ERROR=2, WARN=1, OK=0)
-   * \param delay Publish trace after delay cyles.  For 1kHz realtime loop 1cycle = 1ms.
+   * \param delay Publish trace after delay cyles.  Length of cycle is given by cycle_period_.
    * \return Return true if device support publishing trace.  False, if not.
    */  
   virtual bool publishTrace(const string &reason, unsigned level, unsigned delay) {return false;}
@@ -217,6 +263,12 @@ public:
   EtherCAT_SlaveHandler *sh_;
   unsigned int command_size_;
   unsigned int status_size_;
+  //! Process data of device is exchanged once every exchange_divisor_ cycles
+  unsigned int exchange_divisor_;
+  //! Offset of device command and status in process data buffer
+  unsigned int process_data_offset_;
+  //! Period of realtime loop in seconds, set before initialize() is called
+  double cycle_period_;
   
   // The device diagnostics are collected with a non-readtime thread that calls collectDiagnostics()
   // The device published from the realtime loop by indirectly invoking ethercatDiagnostics()
@@ -38,6 +38,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
 
 #include <pr2_hardware_interface/hardware_interface.h>
 
@@ -48,8 +49,12 @@
 #include "ethercat_hardware/ethercat_device.h"
 #include "ethercat_hardware/ethercat_com.h"
 #include "ethercat_hardware/ethernet_interface_info.h"
+#include "ethercat_hardware/cyclic_table.h"
+#include "ethercat_hardware/process_data_snapshot.h"
+#include "ethercat_hardware/shared_memory_interface.h"
+#include "ethercat_hardware/cycle_deadline_monitor.h"
 
-#include <realtime_tools/realtime_publisher.h>
+#include <ethercat_hardware/publisher_executor.h>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
@@ -57,6 +62,7 @@
 #include <boost/accumulators/statistics/mean.hpp>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
 
 #include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
@@ -89,6 +95,13 @@ struct EthercatHardwareDiagnostics
   unsigned reset_motors_service_count_; //!< Number of times reset_motor service has been used
   unsigned halt_motors_service_count_;  //!< Number of time halt_motor service call is used
   unsigned halt_motors_error_count_;    //!< Number of transitions into halt state due to device error
+  unsigned reconnected_devices_;        //!< Number of times a reset device was brought back without restarting
+  bool shared_memory_enabled_;          //!< True if actuators are mirrored to shared memory
+  unsigned shared_memory_latency_;      //!< Age in cycles of last commands from shared memory
+  unsigned shared_memory_max_latency_;
+  uint64_t shared_memory_stale_cycles_; //!< Cycles where shared memory commands were too old, and actuators were disabled
+  uint64_t shared_memory_torn_reads_;   //!< Cycles where controller was writing commands, and previous commands were used
+  ethercat_hardware::CycleDeadlineMonitor::Stats deadline_stats_; //!< Deadline overruns of realtime cycle
   struct netif_counters counters_;
   bool input_thread_is_stopped_;
   bool motors_halted_; //!< True if motors are halted  
@@ -250,12 +263,18 @@ public:
    * \param position device ring position to publish trace for.  Use -1 to trigger all devices.
    * \param reason Message to put in trace as reason. 
    * \param level Level to put in trace (aka ERROR=2, WARN=1, OK=0)
-   * \param delay Publish trace after delay cyles.  For 1kHz realtime loop 1cycle = 1ms.
+   * \param delay Publish trace after delay cyles.  Length of cycle is given by cycle_period parameter.
    * \return Return true if device supports publishing trace.  False, if not.   
    *         If all devices are triggered, returns true if any device publishes trace.
    */
   bool publishTrace(int position, const string &reason, unsigned level, unsigned delay);
 
+  /*!
+   * \brief Lock-free view of process data of latest cycle, for in-process tools running outside realtime loop.
+   * Valid once init() returns, until EthercatHardware is destroyed.
+   */
+  const ethercat_hardware::ProcessDataSnapshot &snapshot() const {return snapshot_;}
+
   pr2_hardware_interface::HardwareInterface *hw_;
 
 private:
@@ -274,20 +293,106 @@ private:
   EtherCAT_AL *al_;
   EtherCAT_Master *em_;
 
+  void indexDeviceClasses();
   boost::shared_ptr<EthercatDevice> configSlave(EtherCAT_SlaveHandler *sh);
+  //! Driver class names of device_loader_, indexed by product ID (last part of class name)
+  typedef std::map<std::string, std::string> DeviceClassMap;
+  DeviceClassMap device_classes_;
+  bool relayoutProcessData();
+  void reconnectResetSlaves();
+  bool reconnectSlave(unsigned slave);
+  bool oobChangeState(EtherCAT_SlaveHandler *sh, EC_State new_state);
+  void constructInExchangeOrder();
+
+  /*!
+   * \brief Description of one EtherCAT device, as saved in chain cache file
+   */
+  struct ChainCacheEntry
+  {
+    unsigned product_code_;
+    unsigned serial_;
+    unsigned revision_;
+    unsigned layout_;                //!< EthercatDevice::processDataLayout()
+    unsigned exchange_divisor_;
+    unsigned process_data_offset_;   //!< Offset of device in process data, from start of logical address space
+  };
+  bool loadChainCache();
+  bool chainCacheMatchesLayout() const;
+  void forgetChainCache();
+  void saveChainCache();
+  std::string chain_cache_file_;      //!< Empty if chain cache is disabled
+  std::vector<ChainCacheEntry> chain_cache_;
+  unsigned chain_cache_buffer_size_;  //!< Process data size of previous run
+
+  /*!
+   * \brief Start and end of each startup step of one device.
+   * Times are in seconds since device initialization began, zero if step was not run separately.
+   */
+  struct StartupTimeline
+  {
+    double pre_initialize_start_;
+    double pre_initialize_end_;
+    double initialize_start_;
+    double initialize_end_;
+    int pre_initialize_result_;
+  };
+  double startupTime() const;
+  void preInitializeSlaves(bool allow_unprogrammed, unsigned num_threads);
+  void preInitializeThreadFunc(bool allow_unprogrammed);
+  void initializeFailed(unsigned slave);
+  void reportStartupTimeline(unsigned num_threads);
+  std::vector<StartupTimeline> startup_timeline_;
+  ros::WallTime startup_start_;
+  boost::mutex pre_initialize_mutex_;  //!< Protects next_pre_initialize_
+  unsigned next_pre_initialize_;       //!< Next device to be pre-initialized by worker threads
+
+  void sortExchangeOrder();
+  void buildExchangeGroups();
+  //! Logical address of first byte of process data
+  static const int PROCESS_DATA_START_ADDRESS = 0x00010000;
   std::vector<boost::shared_ptr<EthercatDevice> > slaves_;
   unsigned int num_ethercat_devices_;
 
+  ethercat_hardware::CycleDeadlineMonitor deadline_monitor_;
+  std::string deadline_capture_dir_;      //!< Captures are only logged if empty
+  unsigned deadline_captures_saved_;
+  void saveDeadlineCapture(const std::vector<ethercat_hardware::CycleDeadlineMonitor::CycleRecord> &records, 
+                           const std::string &reason);
+  ethercat_hardware::SharedMemoryMirror shared_memory_;  //!< Only initialized if shared_memory_name parameter is set
+  ethercat_hardware::ProcessDataSnapshot snapshot_;  //!< Publishes prev_buffer_ after each cycle
   unsigned char *this_buffer_;
   unsigned char *prev_buffer_;
   unsigned char *buffers_;
   unsigned int buffer_size_;
 
+  /*!
+   * \brief Devices with same exchange divisor.
+   *
+   * Process data of slower groups is placed after faster groups, and divisor of each group 
+   * is a multiple of divisor of group before it.  So on any cycle, devices that need to be 
+   * exchanged form a prefix of the process data, and only that prefix is sent.
+   */
+  struct ExchangeGroup
+  {
+    unsigned divisor_;    //!< Devices of group are exchanged once every divisor_ cycles
+    unsigned end_;        //!< One past last device of group in exchange_order_
+    unsigned size_;       //!< Bytes of process data up to and including this group
+    bool reset_pending_;  //!< Reset was requested since devices of group were last exchanged
+    ethercat_hardware::CyclicTable table_; //!< Devices of group, sorted by type for pack and unpack
+  };
+  std::vector<ExchangeGroup> exchange_groups_;
+  std::vector<unsigned> exchange_order_; //!< Index of slaves, in order of process data layout
+  unsigned exchange_cycle_; //!< Cycle count, modulo divisor of slowest group
+
   bool halt_motors_;
   unsigned int reset_state_;
+  double cycle_period_;     //!< Period of realtime loop in seconds, all cycle counts are derived from this
+  unsigned cycles_per_halt_release_; //!< Cycles to wait between releasing each device from halt after reset
 
   unsigned timeout_;        //!< Timeout (in microseconds) to used for sending/recieving packets once in realtime mode.
   unsigned max_pd_retries_; //!< Max number of times to retry sending process data before halting motors
+  bool reconnect_reset_devices_;  //!< If true, devices that are reset are brought back while chain keeps running
+  boost::atomic<unsigned> reconnected_devices_;  //!< Counted by diagnostics thread, copied into diagnostics_ by realtime loop
 
   void publishDiagnostics();  //!< Collects raw diagnostics data and passes it to diagnostics_publisher
   static void updateAccMax(double &max, const accumulator_set<double, stats<tag::max, tag::mean> > &acc);
@@ -296,7 +401,7 @@ private:
   ros::Time last_published_;
   ros::Time last_reset_;
 
-  realtime_tools::RealtimePublisher<std_msgs::Bool> motor_publisher_;
+  ethercat_hardware::ExecutorPublisher<std_msgs::Bool> motor_publisher_;
 
   EthercatOobCom *oob_com_;  
 
@@ -0,0 +1,117 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__FINGERTIP_CONTACT_H
+#define ETHERCAT_HARDWARE__FINGERTIP_CONTACT_H
+
+#include <stdint.h>
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Detects contact on a PR2 fingertip pressure sensor, and locates its centroid.
+ *
+ * Uses same cell geometry and force-per-unit scaling as fingertip_geometry.py 
+ * in fingertip_pressure package, so results match what is shown by the 
+ * fingertip visualization tools.
+ *
+ * Each cell reading has a baseline removed and is scaled to a force estimate.  
+ * Sum of cell forces gives total force, contact is flagged when total is 
+ * above threshold, and centroid is force-weighted average of cell centers 
+ * in fingertip link frame.
+ */
+class FingertipContact
+{
+public:
+  static const unsigned NUM_CELLS = 22;
+
+  //! Values exposed through hardware interface, in this order
+  enum { CONTACT=0, TOTAL_FORCE, CENTROID_X, CENTROID_Y, CENTROID_Z, NUM_OUTPUTS };
+
+  /*!
+   * \param orientation  1 for left fingertip, -1 for right fingertip (mirrors Y and Z)
+   */
+  FingertipContact(int orientation=1);
+
+  void setOrientation(int orientation);
+  //! Total force needed to flag contact
+  void setThreshold(double threshold) {threshold_ = threshold;}
+  //! Number of readings averaged into baseline when zero() is called
+  void setZeroSamples(unsigned zero_samples) {zero_samples_ = (zero_samples < 1) ? 1 : zero_samples;}
+
+  //! Start measuring new baseline from following readings, fingertip should not be touching anything
+  void zero();
+  //! True while baseline is being measured
+  bool isZeroing() const {return zero_count_ < zero_samples_;}
+
+  /*!
+   * \brief Update contact estimate from new cell readings
+   *
+   * \param cells  NUM_CELLS readings, in host byte order
+   */
+  void update(const uint16_t *cells);
+
+  bool contact() const {return contact_;}
+  double totalForce() const {return total_force_;}
+  const double *centroid() const {return centroid_;}
+  //! Force estimate of each cell from last update
+  const double *cellForces() const {return cell_force_;}
+
+  //! Copy results into NUM_OUTPUTS element array
+  void getOutputs(double *outputs) const;
+
+  //! Center of each cell in left fingertip link frame (meters)
+  static const double CELL_CENTERS[NUM_CELLS][3];
+  //! Cell reading per unit of force
+  static const double FORCE_PER_UNIT[NUM_CELLS];
+
+protected:
+  double centers_[NUM_CELLS][3];
+  double threshold_;
+
+  unsigned zero_samples_;
+  unsigned zero_count_;
+  double zero_sum_[NUM_CELLS];
+  double baseline_[NUM_CELLS];
+
+  double cell_force_[NUM_CELLS];
+  bool contact_;
+  double total_force_;
+  double centroid_[3];
+};
+
+}; // end namespace ethercat_hardware
+
+#endif //ETHERCAT_HARDWARE__FINGERTIP_CONTACT_H
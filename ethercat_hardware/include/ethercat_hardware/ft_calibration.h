@@ -0,0 +1,134 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__FT_CALIBRATION_H
+#define ETHERCAT_HARDWARE__FT_CALIBRATION_H
+
+#include <stdint.h>
+
+struct FTDataSample
+{
+  int16_t data_[6];
+  uint16_t vhalf_;
+  uint8_t sample_count_;
+  uint8_t timestamp_;
+  static const unsigned SIZE=16;
+}__attribute__ ((__packed__));
+
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Error conditions detected while converting raw F/T samples.
+ *
+ * Flags are only ever set by FTCalibration::convert(), never cleared, 
+ * so a single instance can be used to accumulate errors over many cycles.
+ */
+struct FTSampleErrors
+{
+  FTSampleErrors() : overload_flags_(0), disconnected_(false), vhalf_error_(false) {}
+  uint8_t overload_flags_; //!< Bits 0-5 set to true if raw FT input goes beyond limit
+  bool disconnected_;      //!< Vhalf reads 0x0000 or 0xFFFF : WG035 is likely not present
+  bool vhalf_error_;       //!< Vhalf is out of range, but not stuck at a rail
+};
+
+
+/*!
+ * \brief Converts raw F/T ADC samples into forces and torques.
+ *
+ * The gain, offset and calibration matrix given to configure() are folded into 
+ * a single affine transform, so that each sample is converted with 
+ *
+ *   Force/Torque = M * ADCValues + b
+ *
+ * where M(i,j) = Coeff(i,j) / (Gain(j) * 2^16) and b = -M * Offset.
+ * This replaces a divide per channel and a separate 6x6 matrix multiply.
+ *
+ * convert() processes all samples received in a cycle in one batch.  
+ * When SSE2 is available the matrix multiply and the overload/vhalf range 
+ * checks are done with vector instructions and without data-dependent branches.
+ */
+class FTCalibration
+{
+public:
+  static const unsigned NUM_CHANNELS = 6;
+  static const int VHALF_IDEAL = 32768; //!< Vhalf ADC measurement is ideally about (1<<16)/2
+  static const int VHALF_RANGE = 300;   //!< allow vhalf to range +/- 300 from ideal
+
+  FTCalibration();
+
+  /*!
+   * \brief Precompute affine transform from calibration parameters.
+   *
+   * \param calibration_coeff  6x6 calibration matrix in row-major order
+   * \param offsets            offset of each raw input channel
+   * \param gains              amplifier gain of each raw input channel
+   * \param overload_limit     raw values with magnitude above this are flagged as overload
+   */
+  void configure(const double calibration_coeff[36], const double offsets[6], const double gains[6], 
+                 int overload_limit);
+
+  /*!
+   * \brief Convert a batch of samples to force/torque values.
+   *
+   * \param samples     raw samples to convert
+   * \param num_samples number of samples in samples and wrenches
+   * \param wrenches    output : Fx,Fy,Fz,Tx,Ty,Tz for each sample, in same order as samples
+   * \param errors      error flags are or'ed into this structure
+   */
+  void convert(const FTDataSample *samples, unsigned num_samples, 
+               double (*wrenches)[NUM_CHANNELS], FTSampleErrors &errors) const;
+
+  //! Portable (non-vectorized) version of convert()
+  void convertScalar(const FTDataSample *samples, unsigned num_samples, 
+                     double (*wrenches)[NUM_CHANNELS], FTSampleErrors &errors) const;
+
+  //! Element (row, col) of folded transform matrix
+  double transform(unsigned row, unsigned col) const {return columns_[col][row];}
+  //! Element of folded transform bias
+  double bias(unsigned row) const {return bias_[row];}
+
+protected:
+  static void checkVhalf(uint16_t vhalf, FTSampleErrors &errors);
+
+  //! Folded transform matrix, stored by column so each raw input scales one contiguous column
+  double columns_[NUM_CHANNELS][NUM_CHANNELS] __attribute__ ((aligned (16)));
+  double bias_[NUM_CHANNELS] __attribute__ ((aligned (16)));
+  int16_t overload_limit_;
+};
+
+}; // end namespace ethercat_hardware
+
+#endif //ETHERCAT_HARDWARE__FT_CALIBRATION_H
@@ -0,0 +1,136 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__FT_FILTER_H
+#define ETHERCAT_HARDWARE__FT_FILTER_H
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Filtering and bias removal for force/torque samples.
+ *
+ * Each sample passes through these stages : 
+ *  1. Cascade of biquad (2nd order IIR) sections
+ *  2. Moving-average decimator, that outputs average of every N samples
+ *  3. Bias removal, bias is estimated from output of decimator when tare() is called
+ *
+ * All state is stored in fixed size arrays, so filter() never allocates memory
+ * and can be run from realtime loop.  Each stage processes all 6 channels together 
+ * with channel as inner loop, so compiler can vectorize the per-channel math.
+ */
+class FTFilter
+{
+public:
+  static const unsigned NUM_CHANNELS = 6;
+  static const unsigned MAX_BIQUADS = 8;
+
+  //! Biquad coefficients normalized so a0 = 1
+  struct Biquad
+  {
+    double b0_, b1_, b2_, a1_, a2_;
+  };
+
+  FTFilter();
+
+  /*!
+   * \brief Design 2nd order low-pass section (RBJ audio EQ cookbook)
+   *
+   * \param cutoff      cutoff frequency in Hz, should be less than sample_rate/2
+   * \param q           quality factor, sqrt(0.5) gives butterworth response
+   * \param sample_rate rate of input samples in Hz
+   */
+  static Biquad lowpass(double cutoff, double q, double sample_rate);
+
+  //! Append biquad section to cascade. Returns false if cascade is already full.
+  bool addBiquad(const Biquad &biquad);
+  //! Remove all biquad sections
+  void clearBiquads();
+  //! Number of biquad sections in cascade
+  unsigned numBiquads() const {return num_biquads_;}
+
+  //! Set number of samples averaged into each output sample. 1 disables decimation.
+  void setDecimation(unsigned decimation);
+  unsigned decimation() const {return decimation_;}
+
+  //! Set number of decimated samples averaged to estimate bias
+  void setTareSamples(unsigned tare_samples);
+
+  /*!
+   * \brief Start estimating bias.  
+   *
+   * Bias is updated once tare samples have been collected, until then old bias is used.
+   */
+  void tare();
+  //! True while bias is being estimated
+  bool isTaring() const {return taring_;}
+  //! Current bias that is subtracted from output
+  const double *bias() const {return bias_;}
+
+  //! Clear filter and decimator state.  Next sample will re-initialize biquads.
+  void reset();
+
+  /*!
+   * \brief Run one sample through filter
+   *
+   * \param in   Fx,Fy,Fz,Tx,Ty,Tz of input sample
+   * \param out  filtered, bias-free output, only written when function returns true
+   * \return     true if decimator produced an output sample
+   */
+  bool filter(const double in[NUM_CHANNELS], double out[NUM_CHANNELS]);
+
+protected:
+  void prime(const double in[NUM_CHANNELS]);
+
+  Biquad biquads_[MAX_BIQUADS];
+  unsigned num_biquads_;
+  //! Transposed direct form II state of each section and channel
+  double z1_[MAX_BIQUADS][NUM_CHANNELS];
+  double z2_[MAX_BIQUADS][NUM_CHANNELS];
+  bool primed_;
+
+  unsigned decimation_;
+  unsigned decimation_count_;
+  double decimation_sum_[NUM_CHANNELS];
+
+  unsigned tare_samples_;
+  unsigned tare_count_;
+  bool taring_;
+  double tare_sum_[NUM_CHANNELS];
+  double bias_[NUM_CHANNELS];
+};
+
+}; // end namespace ethercat_hardware
+
+#endif //ETHERCAT_HARDWARE__FT_FILTER_H
@@ -39,7 +39,7 @@
 #include "ethercat_hardware/MotorTraceSample.h"
 #include "ethercat_hardware/ActuatorInfo.h"
 
-#include "realtime_tools/realtime_publisher.h"
+#include "ethercat_hardware/publisher_executor.h"
 #include "diagnostic_updater/DiagnosticStatusWrapper.h"
 
 #include <boost/utility.hpp>
@@ -291,7 +291,7 @@ protected:
   //! Sample interval for trace (in seconds)
   //double trace_sample_interval_;
   //! realtime publisher for MotorHeatingSample
-  realtime_tools::RealtimePublisher<ethercat_hardware::MotorTemperature> *publisher_;
+  ethercat_hardware::ExecutorPublisher<ethercat_hardware::MotorTemperature> *publisher_;
 
   MotorHeatingModelParameters motor_params_;
   std::string actuator_name_;  //!< name of actuator (ex. fl_caster_rotation_motor)
@@ -6,7 +6,7 @@
 #include <string>
 #include <vector>
 
-#include <realtime_tools/realtime_publisher.h>
+#include <ethercat_hardware/publisher_executor.h>
 #include <ethercat_hardware/MotorTraceSample.h>
 #include <ethercat_hardware/MotorTrace.h>
 #include <ethercat_hardware/ActuatorInfo.h>
@@ -20,7 +20,7 @@
 class MotorModel : private boost::noncopyable
 {
 public:
-  MotorModel(unsigned trace_size);
+  MotorModel(unsigned trace_size, double cycle_period=0.001);
   bool initialize(const ethercat_hardware::ActuatorInfo &actuator_info, 
                   const ethercat_hardware::BoardInfo &board_info);
   void flagPublish(const std::string &reason, int level, int delay);
@@ -29,8 +29,13 @@ public:
   void sample(const ethercat_hardware::MotorTraceSample &s);
   bool verify();
   void reset();
+  //! Number of cycles closest to given amount of time
+  int cycles(double seconds) const { return int(seconds / cycle_period_ + 0.5); }
+  static double scaleFilterCoefficient(double coefficient, double cycle_period);
 protected:
   unsigned trace_size_;
+  double cycle_period_; //!< Period of realtime loop in seconds
+  int max_publish_delay_; //!< Longest delay (in cycles) that still leaves error in published trace
   unsigned trace_index_; /* index of most recent element in trace vector */
   unsigned published_traces_;
   ethercat_hardware::ActuatorInfo actuator_info_;
@@ -38,7 +43,7 @@ protected:
   double backemf_constant_;
   bool previous_pwm_saturated_;
   std::vector<ethercat_hardware::MotorTraceSample> trace_buffer_;
-  realtime_tools::RealtimePublisher<ethercat_hardware::MotorTrace> *publisher_;
+  ethercat_hardware::ExecutorPublisher<ethercat_hardware::MotorTrace> *publisher_;
   double current_error_limit_;
   int publish_delay_;
   int publish_level_;
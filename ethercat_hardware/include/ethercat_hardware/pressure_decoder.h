@@ -0,0 +1,95 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__PRESSURE_DECODER_H
+#define ETHERCAT_HARDWARE__PRESSURE_DECODER_H
+
+#include <stdint.h>
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Decodes fingertip pressure cells from WG06 process data.
+ *
+ * Device sends cells of both fingertips as one contiguous array of big-endian 
+ * 16bit values (left fingertip first).  decode() byte-swaps all cells into a 
+ * preallocated aligned array, using SSE2 when it is available.  
+ *
+ * Optionally, per-cell calibration (raw - offset) * gain is applied to produce 
+ * calibrated values in a second preallocated array.
+ */
+class PressureDecoder
+{
+public:
+  static const unsigned NUM_SENSORS = 2;
+  static const unsigned NUM_CELLS = 22;  //!< Cells per fingertip sensor
+  static const unsigned TOTAL_CELLS = NUM_SENSORS * NUM_CELLS;
+
+  PressureDecoder();
+
+  /*!
+   * \brief Set calibration of one fingertip sensor, and enable calibration
+   *
+   * \param sensor   0 for left fingertip, 1 for right fingertip
+   * \param offsets  NUM_CELLS raw offset values
+   * \param gains    NUM_CELLS gains
+   */
+  void setCalibration(unsigned sensor, const double *offsets, const double *gains);
+  //! True once setCalibration() has been called
+  bool hasCalibration() const {return has_calibration_;}
+
+  /*!
+   * \brief Byte-swap and calibrate all cells
+   *
+   * \param cells   TOTAL_CELLS big-endian 16bit values, does not need to be aligned
+   */
+  void decode(const void *cells);
+
+  //! Host-order cell values of one sensor
+  const uint16_t *raw(unsigned sensor) const {return &raw_[sensor*NUM_CELLS];}
+  //! Calibrated cell values of one sensor, only valid if hasCalibration() 
+  const double *calibrated(unsigned sensor) const {return &calibrated_[sensor*NUM_CELLS];}
+
+protected:
+  bool has_calibration_;
+  uint16_t raw_[TOTAL_CELLS] __attribute__ ((aligned (16)));
+  double calibrated_[TOTAL_CELLS] __attribute__ ((aligned (16)));
+  double offsets_[TOTAL_CELLS];
+  double gains_[TOTAL_CELLS];
+};
+
+}; // end namespace ethercat_hardware
+
+#endif //ETHERCAT_HARDWARE__PRESSURE_DECODER_H
@@ -0,0 +1,109 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__PROCESS_DATA_SNAPSHOT_H
+#define ETHERCAT_HARDWARE__PROCESS_DATA_SNAPSHOT_H
+
+#include <boost/utility.hpp>
+#include <boost/atomic.hpp>
+#include <stdint.h>
+#include <vector>
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Read-only view of process data of most recent cycle, for non-realtime readers.
+ *
+ * Realtime loop does not copy anything for readers.  It publishes the process data buffer it 
+ * just unpacked, and bumps a sequence counter (seqlock) around the short window where 
+ * that buffer is modified again.  Readers never block realtime loop : they read data in 
+ * place, then check that sequence did not change while they were reading.
+ *
+ * \code
+ * ProcessDataSnapshot::View view;
+ * while (true) {
+ *   if (!snapshot.begin(view)) continue;
+ *   memcpy(&status, view.data_ + snapshot.deviceOffset(slave) + command_size, sizeof(status));
+ *   if (snapshot.validate(view)) break;
+ * }
+ * \endcode
+ *
+ * Data read before validate() returns true may be torn, and must not be trusted.
+ */
+class ProcessDataSnapshot : private boost::noncopyable
+{
+public:
+  ProcessDataSnapshot();
+
+  struct View
+  {
+    const unsigned char *data_;  //!< Process data, laid out as exchanged with devices
+    unsigned size_;
+    uint64_t version_;           //!< Number of cycles published so far
+    uint64_t sequence_;
+  };
+
+  /*!
+   * \brief Starts reading latest process data
+   * \return false if nothing is published yet, or realtime loop is modifying data; try again
+   */
+  bool begin(View &view) const;
+  //! Returns true if data read since begin() is consistent
+  bool validate(const View &view) const;
+  //! Number of cycles published so far
+  uint64_t version() const {return sequence_.load(boost::memory_order_acquire) / 2;}
+
+  //! Offset of device data in view, indexed like EthercatHardware slaves
+  unsigned deviceOffset(unsigned slave) const {return offsets_.at(slave);}
+  unsigned numDevices() const {return offsets_.size();}
+
+  //! Called before realtime loop starts, with offset of each device in process data buffers
+  void setLayout(const std::vector<unsigned> &offsets);
+  //! Called by realtime loop before it modifies published buffer
+  void beginUpdate();
+  //! Called by realtime loop to publish buffer with latest data
+  void publish(const unsigned char *buffer, unsigned size);
+
+protected:
+  boost::atomic<uint64_t> sequence_;  //!< Odd while published buffer is being modified
+  boost::atomic<const unsigned char*> buffer_;
+  boost::atomic<unsigned> size_;
+  bool updating_;
+  std::vector<unsigned> offsets_;
+};
+
+}
+
+#endif /* ETHERCAT_HARDWARE__PROCESS_DATA_SNAPSHOT_H */
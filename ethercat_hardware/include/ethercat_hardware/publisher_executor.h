@@ -0,0 +1,192 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__PUBLISHER_EXECUTOR_H
+#define ETHERCAT_HARDWARE__PUBLISHER_EXECUTOR_H
+
+#include <ros/ros.h>
+
+#include <boost/utility.hpp>
+#include <boost/function.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/lockfree/queue.hpp>
+
+#include <semaphore.h>
+#include <string>
+#include <vector>
+
+namespace ethercat_hardware
+{
+
+class PublisherExecutor;
+
+/*!
+ * \brief Message slot that realtime loop fills in, and executor publishes.
+ *
+ * Interface matches realtime_tools::RealtimePublisher : realtime loop calls 
+ * trylock(), fills in message, then calls unlockAndPublish().  Instead of 
+ * waking a thread of its own, slot is handed to shared PublisherExecutor.
+ *
+ * State of slot is kept in a single atomic, so trylock() and unlockAndPublish() 
+ * never block.
+ */
+class PublisherSlot : private boost::noncopyable
+{
+public:
+  PublisherSlot(PublisherExecutor &executor);
+  virtual ~PublisherSlot();
+
+  //! Try to get message for writing.  Fails if message is waiting to be published, or being published.
+  bool trylock();
+  //! Wait until message can be written.  May block, so should not be used in realtime loop.
+  void lock();
+  //! Give up message without publishing it
+  void unlock();
+  //! Hand message to executor for publishing.  Never blocks.
+  void unlockAndPublish();
+  //! Wait for any pending publish to finish
+  void stop();
+
+protected:
+  friend class PublisherExecutor;
+
+  //! Called from executor thread to serialize and publish message
+  virtual void publish() = 0;
+  //! Called by executor : publishes message, then makes slot available to realtime loop
+  void run();
+
+  enum {IDLE, WRITING, READY, PUBLISHING};
+  boost::atomic<int> state_;
+  PublisherExecutor &executor_;
+};
+
+
+/*!
+ * \brief Drop-in replacement for realtime_tools::RealtimePublisher that is published by shared executor.
+ */
+template <class Msg>
+class ExecutorPublisher : public PublisherSlot
+{
+public:
+  ExecutorPublisher(const ros::NodeHandle &node, const std::string &topic, int queue_size, bool latched=false);
+  ~ExecutorPublisher() {stop();}
+
+  Msg msg_;
+
+protected:
+  void publish() {publisher_.publish(msg_);}
+  ros::Publisher publisher_;
+};
+
+
+/*!
+ * \brief Small, fixed set of threads that publish messages for all devices.
+ *
+ * Realtime loop hands ready slots to executor through a bounded lock-free queue, 
+ * and wakes an executor thread with a semaphore, so it never blocks or allocates.
+ * Executor threads also run periodic tasks, such as draining sample streams.
+ *
+ * Number of threads does not depend on number of devices or topics.
+ */
+class PublisherExecutor : private boost::noncopyable
+{
+public:
+  static const unsigned DEFAULT_THREADS = 2;
+  static const unsigned MAX_PENDING = 1024;  //!< Max number of slots waiting to be published
+
+  //! Executor shared by all devices
+  static PublisherExecutor &instance();
+
+  explicit PublisherExecutor(unsigned num_threads);
+  ~PublisherExecutor();
+
+  //! Queue slot for publishing.  Returns false if queue is full.  Never blocks.
+  bool schedule(PublisherSlot *slot);
+
+  /*!
+   * \brief Run task from executor thread every period seconds
+   * \return id to pass to removePeriodic()
+   */
+  unsigned addPeriodic(const boost::function<void()> &task, double period);
+  //! Stop running periodic task.  Waits for task if it is currently running.
+  void removePeriodic(unsigned id);
+
+  unsigned numThreads() const {return num_threads_;}
+  //! Number of slots that could not be queued because queue was full
+  uint64_t droppedCount() const {return dropped_count_;}
+
+protected:
+  struct PeriodicTask
+  {
+    unsigned id_;
+    boost::function<void()> task_;
+    double period_;
+    double next_time_;
+    bool running_;
+  };
+
+  static double now();
+  void threadFunc();
+  //! Returns time of next periodic task, or time limit if there is nothing sooner
+  double nextDeadline(double limit);
+  void runPeriodic();
+
+  unsigned num_threads_;
+  boost::lockfree::queue<PublisherSlot*> ready_;
+  sem_t semaphore_;
+  boost::atomic<bool> shutdown_;
+  boost::atomic<uint64_t> dropped_count_;
+  boost::thread_group threads_;
+
+  boost::mutex periodic_mutex_;
+  boost::condition_variable periodic_cond_;
+  std::vector<PeriodicTask> periodic_;
+  unsigned next_periodic_id_;
+};
+
+
+template <class Msg>
+ExecutorPublisher<Msg>::ExecutorPublisher(const ros::NodeHandle &node, const std::string &topic, int queue_size, bool latched) :
+  PublisherSlot(PublisherExecutor::instance())
+{
+  ros::NodeHandle nh(node);
+  publisher_ = nh.advertise<Msg>(topic, queue_size, latched);
+}
+
+}; // end namespace ethercat_hardware
+
+#endif //ETHERCAT_HARDWARE__PUBLISHER_EXECUTOR_H
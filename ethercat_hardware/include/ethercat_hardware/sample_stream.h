@@ -0,0 +1,195 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__SAMPLE_STREAM_H
+#define ETHERCAT_HARDWARE__SAMPLE_STREAM_H
+
+#include <ros/ros.h>
+
+#include "ethercat_hardware/publisher_executor.h"
+
+#include <boost/utility.hpp>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/atomic.hpp>
+
+#include <string>
+
+namespace ethercat_hardware
+{
+
+/*!
+ * \brief Passes every sensor sample from realtime loop to a non-realtime publisher.
+ *
+ * RealtimePublisher drops a message whenever the publishing thread still holds 
+ * the lock from the previous cycle.  This stream instead puts each sample 
+ * (along with its sample count) into a single-producer/single-consumer lock-free 
+ * ring.  A periodic task of the shared PublisherExecutor drains the ring and 
+ * publishes the samples in batches.
+ *
+ * Samples are only lost if the ring fills up, which is counted by overflowCount().
+ * Gaps in sample_count of published samples also show samples the hardware missed.
+ *
+ * Traits describes the type of sample and message : 
+ *   Traits::Sample   : POD type pushed by realtime loop
+ *   Traits::Message  : ROS message with 'samples' vector and 'sample_count' field
+ *   Traits::appendSample(Message &msg, uint64_t sample_count, const Sample &sample)
+ *   Traits::finishBatch(Message &msg, uint64_t overflow_count)
+ */
+template <class Traits>
+class SampleStream : private boost::noncopyable
+{
+public:
+  typedef typename Traits::Sample Sample;
+  typedef typename Traits::Message Message;
+
+  SampleStream() :
+    capacity_(0),
+    overflow_count_(0),
+    published_count_(0),
+    publish_period_(0.01),
+    periodic_id_(0)
+  {
+  }
+
+  ~SampleStream()
+  {
+    if (periodic_id_ != 0)
+    {
+      PublisherExecutor::instance().removePeriodic(periodic_id_);
+      // Publish whatever is left in ring
+      publishBatch();
+    }
+  }
+
+  /*!
+   * \brief Allocate ring, advertise topic, and start publishing batches.
+   *
+   * \param topic           topic to publish batches on
+   * \param capacity        number of samples ring can hold
+   * \param publish_period  time between batches, in seconds
+   */
+  bool initialize(const std::string &topic, unsigned capacity, double publish_period)
+  {
+    if (capacity == 0)
+    {
+      ROS_FATAL("Sample stream '%s' needs capacity of at least one sample", topic.c_str());
+      return false;
+    }
+    if (publish_period <= 0.0)
+    {
+      ROS_FATAL("Sample stream '%s' publish period must be positive, not %f", topic.c_str(), publish_period);
+      return false;
+    }
+
+    capacity_ = capacity;
+    publish_period_ = publish_period;
+    queue_.reset(new boost::lockfree::spsc_queue<Entry>(capacity_));
+
+    // A batch can never be larger than ring
+    msg_.samples.reserve(capacity_);
+
+    ros::NodeHandle nh;
+    publisher_ = nh.advertise<Message>(topic, 10);
+
+    periodic_id_ = PublisherExecutor::instance().addPeriodic(boost::bind(&SampleStream::publishBatch, this), publish_period_);
+    return true;
+  }
+
+  /*!
+   * \brief Put sample into ring.  Called from realtime loop, never blocks or allocates memory.
+   *
+   * \return false if ring was full and sample was dropped
+   */
+  bool push(uint64_t sample_count, const Sample &sample)
+  {
+    Entry entry;
+    entry.sample_count_ = sample_count;
+    entry.sample_ = sample;
+    if (!queue_->push(entry))
+    {
+      overflow_count_.fetch_add(1, boost::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  //! Number of samples dropped because ring was full
+  uint64_t overflowCount() const {return overflow_count_.load(boost::memory_order_relaxed);}
+  //! Number of samples published by executor
+  uint64_t publishedCount() const {return published_count_.load(boost::memory_order_relaxed);}
+  //! Size of ring in samples
+  unsigned capacity() const {return capacity_;}
+
+protected:
+  struct Entry
+  {
+    uint64_t sample_count_;
+    Sample sample_;
+  };
+
+  void publishBatch()
+  {
+    msg_.samples.clear();
+    Entry entry;
+    uint64_t last_sample_count = 0;
+    while (queue_->pop(entry))
+    {
+      Traits::appendSample(msg_, entry.sample_count_, entry.sample_);
+      last_sample_count = entry.sample_count_;
+    }
+
+    if (!msg_.samples.empty())
+    {
+      msg_.sample_count = last_sample_count;
+      Traits::finishBatch(msg_, overflowCount());
+      publisher_.publish(msg_);
+      published_count_.fetch_add(msg_.samples.size(), boost::memory_order_relaxed);
+    }
+  }
+
+  boost::scoped_ptr< boost::lockfree::spsc_queue<Entry> > queue_;
+  unsigned capacity_;
+  boost::atomic<uint64_t> overflow_count_;   //!< Only written by realtime thread
+  boost::atomic<uint64_t> published_count_;  //!< Only written by executor
+  double publish_period_;
+  unsigned periodic_id_;  //!< Id of periodic executor task, 0 if not started
+  ros::Publisher publisher_;
+  Message msg_;
+};
+
+}; // end namespace ethercat_hardware
+
+#endif //ETHERCAT_HARDWARE__SAMPLE_STREAM_H
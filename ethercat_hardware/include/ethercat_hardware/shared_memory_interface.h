@@ -0,0 +1,226 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef ETHERCAT_HARDWARE__SHARED_MEMORY_INTERFACE_H
+#define ETHERCAT_HARDWARE__SHARED_MEMORY_INTERFACE_H
+
+#include <pr2_hardware_interface/hardware_interface.h>
+
+#include <boost/utility.hpp>
+#include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ethercat_hardware
+{
+
+//! State of one actuator, written by driver every cycle
+struct SharedActuatorState
+{
+  double timestamp_;
+  int32_t sample_timestamp_sec_;     //!< ActuatorState::sample_timestamp_
+  int32_t sample_timestamp_nsec_;
+  double position_;
+  double velocity_;
+  double last_measured_effort_;
+  double last_commanded_effort_;
+  double max_effort_;
+  double last_calibration_rising_edge_;
+  double last_calibration_falling_edge_;
+  double zero_offset_;
+  int32_t encoder_count_;
+  uint8_t is_enabled_;
+  uint8_t halted_;
+  uint8_t calibration_reading_;
+  uint8_t calibration_rising_edge_valid_;
+  uint8_t calibration_falling_edge_valid_;
+  uint8_t pad_[7];
+};
+
+/*!
+ * \brief Command of one actuator, written by controller process
+ *
+ * Driver only applies command to actuators that are claimed.  Actuators that are not 
+ * claimed keep commands of controllers running inside driver process.
+ */
+struct SharedActuatorCommand
+{
+  double effort_;
+  double zero_offset_;        //!< Copied into actuator state when set_zero_offset_ is set, for calibration
+  uint8_t enable_;
+  uint8_t claimed_;           //!< If set, controller process drives this actuator
+  uint8_t set_zero_offset_;
+  uint8_t pad_[5];
+};
+
+static const unsigned SHARED_ACTUATOR_NAME_SIZE = 64;
+
+/*!
+ * \brief Start of shared memory segment.  Followed by actuator states, commands, and names.
+ *
+ * Each side is the only writer of its own sequence counter (seqlock).  Counter is odd 
+ * while data is being written.  Neither side ever waits for the other : a reader that 
+ * sees an odd or changed counter uses data it read before.
+ * Counters written by different processes are kept on separate cache lines.
+ */
+struct SharedMemoryHeader
+{
+  static const uint32_t MAGIC = 0x45434853; // "ECHS"
+  static const uint32_t VERSION = 2;
+
+  uint32_t magic_;
+  uint32_t version_;
+  uint32_t num_actuators_;
+  uint32_t cycle_period_ns_;
+
+  // Written by driver
+  boost::atomic<uint64_t> state_sequence_ __attribute__ ((aligned (64)));
+  uint64_t state_cycle_;                     //!< Cycle of current state data
+  boost::atomic<uint32_t> latency_cycles_;   //!< Age of last commands used, in cycles
+  boost::atomic<uint32_t> max_latency_cycles_;
+  boost::atomic<uint64_t> stale_cycles_;     //!< Cycles where commands timed out and actuators were disabled
+
+  // Written by controller
+  boost::atomic<uint64_t> command_sequence_ __attribute__ ((aligned (64)));
+  uint64_t command_cycle_;                   //!< Cycle of state that commands were computed from
+} __attribute__ ((aligned (64)));
+
+
+/*!
+ * \brief Driver side of shared memory mirror of actuator commands and state.
+ *
+ * Lets controllers run in a separate process.  Every cycle, realtime loop takes most recent 
+ * complete set of commands from shared memory, and writes actuator state back.  
+ * Commands are only applied to actuators that controller process has claimed, all 
+ * other actuators stay with controllers inside driver process.
+ * If controller process stops updating commands for longer than command timeout, 
+ * claimed actuators are disabled until fresh commands arrive.
+ */
+class SharedMemoryMirror : private boost::noncopyable
+{
+public:
+  SharedMemoryMirror();
+  ~SharedMemoryMirror();
+
+  /*!
+   * \brief Creates shared memory segment for all actuators of hardware interface
+   * \param name             name of shared memory object, replaces any existing object of same name
+   * \param cycle_period     period of realtime loop in seconds
+   * \param command_timeout  time in seconds after which commands are considered stale
+   * \return true if successful
+   */
+  bool initialize(const std::string &name, pr2_hardware_interface::HardwareInterface *hw, 
+                  double cycle_period, double command_timeout);
+
+  //! Copies latest complete commands into claimed actuators.  Called from realtime loop, never blocks.
+  void readCommands();
+  //! Copies actuator state into shared memory.  Called from realtime loop, never blocks.
+  void writeState();
+
+  unsigned latencyCycles() const;
+  unsigned maxLatencyCycles() const;
+  uint64_t staleCycles() const;
+  //! Number of cycles where controller was writing commands, so previous commands were used
+  uint64_t tornReads() const {return torn_reads_;}
+
+protected:
+  std::string name_;
+  boost::scoped_ptr<boost::interprocess::shared_memory_object> shm_;
+  boost::scoped_ptr<boost::interprocess::mapped_region> region_;
+  SharedMemoryHeader *header_;
+  SharedActuatorState *states_;
+  SharedActuatorCommand *commands_;
+  std::vector<pr2_hardware_interface::Actuator*> actuators_;  //!< In shared memory order
+  std::vector<SharedActuatorCommand> last_commands_;          //!< Last complete commands read
+  std::vector<SharedActuatorCommand> read_commands_;          //!< Commands being read, swapped with last_commands_
+  uint64_t last_command_cycle_;
+  bool have_commands_;
+  uint64_t cycle_;
+  unsigned timeout_cycles_;
+  uint64_t torn_reads_;
+};
+
+
+/*!
+ * \brief Controller side of shared memory mirror.
+ */
+class SharedMemoryClient : private boost::noncopyable
+{
+public:
+  SharedMemoryClient();
+
+  //! Attaches to shared memory created by driver.  Returns false if it does not exist or does not match.
+  bool attach(const std::string &name);
+
+  unsigned numActuators() const {return header_ ? header_->num_actuators_ : 0;}
+  //! Name of actuator at index
+  std::string actuatorName(unsigned index) const;
+  //! Index of actuator with given name, or -1
+  int actuatorIndex(const std::string &name) const;
+
+  /*!
+   * \brief Copies state of all actuators
+   * \param cycle  set to driver cycle that state is from
+   * \return false if driver was writing state; try again
+   */
+  bool readState(std::vector<SharedActuatorState> &states, uint64_t &cycle) const;
+
+  /*!
+   * \brief Writes commands for all actuators
+   * Only commands with claimed_ set are used by driver.
+   * \param state_cycle  cycle of state used to compute commands, used by driver to measure latency
+   */
+  void writeCommands(const std::vector<SharedActuatorCommand> &commands, uint64_t state_cycle);
+
+  //! Latency of last commands used by driver, in cycles
+  unsigned latencyCycles() const;
+  unsigned maxLatencyCycles() const;
+
+protected:
+  boost::scoped_ptr<boost::interprocess::shared_memory_object> shm_;
+  boost::scoped_ptr<boost::interprocess::mapped_region> region_;
+  SharedMemoryHeader *header_;
+  SharedActuatorState *states_;
+  SharedActuatorCommand *commands_;
+  const char *names_;
+};
+
+}
+
+#endif /* ETHERCAT_HARDWARE__SHARED_MEMORY_INTERFACE_H */
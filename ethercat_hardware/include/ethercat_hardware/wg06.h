@@ -38,6 +38,12 @@
 #include <ethercat_hardware/wg0x.h>
 
 #include <ethercat_hardware/wg_soft_processor.h>
+#include <ethercat_hardware/ft_calibration.h>
+#include <ethercat_hardware/ft_sample_stream.h>
+#include <ethercat_hardware/accel_sample_stream.h>
+#include <ethercat_hardware/ft_filter.h>
+#include <ethercat_hardware/pressure_decoder.h>
+#include <ethercat_hardware/fingertip_contact.h>
 
 #include <pr2_msgs/PressureState.h>
 #include <pr2_msgs/AccelerometerState.h>
@@ -73,16 +79,6 @@ struct WG06StatusWithAccel
 }__attribute__ ((__packed__));
 
 
-struct FTDataSample
-{
-  int16_t data_[6];
-  uint16_t vhalf_;
-  uint8_t sample_count_;
-  uint8_t timestamp_;
-  static const unsigned SIZE=16;
-}__attribute__ ((__packed__));
-
-
 class FTParamsInternal
 {
 public:
@@ -165,8 +161,14 @@ class WG06 : public WG0X
 public:
   WG06();
   ~WG06();
+  int preInitialize(bool allow_unprogrammed);
   int initialize(pr2_hardware_interface::HardwareInterface *, bool allow_unprogrammed=true);
   void construct(EtherCAT_SlaveHandler *sh, int &start_address);
+  bool processDataLayoutChanged() const;
+  unsigned processDataLayout() const;
+  int reconfigure(EthercatCom *com);
+  void expectProcessDataLayout(unsigned layout);
+  unsigned defaultProcessDataLayout() const;
   void packCommand(unsigned char *buffer, bool halt, bool reset);
   bool unpackState(unsigned char *this_buffer, unsigned char *prev_buffer);
 
@@ -184,8 +186,13 @@ private:
   pr2_hardware_interface::Accelerometer accelerometer_;
 
   bool initializePressure(pr2_hardware_interface::HardwareInterface *hw);
+  int writeSensorEnable(EthercatCom *com);
+  bool initializePressureCalibration(pr2_hardware_interface::HardwareInterface *hw);
+  bool initializePressureContact(pr2_hardware_interface::HardwareInterface *hw);
+  void updatePressureContact();
   bool initializeAccel(pr2_hardware_interface::HardwareInterface *hw);
   bool initializeFT(pr2_hardware_interface::HardwareInterface *hw);
+  bool initializeFTFilter(pr2_hardware_interface::HardwareInterface *hw);
   bool initializeSoftProcessor();
 
   bool unpackPressure(unsigned char* pressure_buf);
@@ -203,27 +210,48 @@ private:
   bool pressure_checksum_error_; //!< Set true where checksum error on pressure data is detected, cleared on reset
   unsigned pressure_checksum_error_count_; //!< debugging
   unsigned pressure_size_; //!< Size in bytes of pressure data region
+  //! True if pressure data region is part of cyclic process data (set by construct)
+  bool pressure_mapped_;
+  bool pressureRegionNeeded() const;
 
   unsigned accelerometer_samples_; //!< Number of accelerometer samples since last publish cycle
   unsigned accelerometer_missed_samples_;  //!< Total of accelerometer samples that were missed
+  uint64_t accelerometer_sample_count_; //!< Total number of accelerometer samples
+  //! Lossless stream of every accelerometer sample, NULL unless enabled with accel_stream parameter
+  ethercat_hardware::AccelSampleStream *accel_stream_;
+  //! Used for timestamp of current cycle, may be NULL
+  pr2_hardware_interface::HardwareInterface *hw_;
   ros::Time last_publish_time_; //!< Time diagnostics was last published
   bool first_publish_; 
 
   static const unsigned NUM_PRESSURE_REGIONS = 22;    
   uint32_t last_pressure_time_;
-  realtime_tools::RealtimePublisher<pr2_msgs::PressureState> *pressure_publisher_;
-  realtime_tools::RealtimePublisher<pr2_msgs::AccelerometerState> *accel_publisher_;
+  ethercat_hardware::ExecutorPublisher<pr2_msgs::PressureState> *pressure_publisher_;
+  //! Byte-swaps (and optionally calibrates) pressure cells of both fingertips
+  ethercat_hardware::PressureDecoder pressure_decoder_;
+  //! Provides calibrated pressure values to controllers, only registered if calibration is given
+  pr2_hardware_interface::AnalogIn pressure_calibrated_analog_in_[2];
+
+  //! True if pressure_contact parameters were given
+  bool enable_pressure_contact_;
+  //! Contact detection for left and right fingertips
+  ethercat_hardware::FingertipContact fingertip_contact_[2];
+  //! Provides contact flag, total force, and centroid of each fingertip to controllers
+  pr2_hardware_interface::AnalogIn pressure_contact_analog_in_[2];
+  //! Controllers set this to non-zero to re-zero contact baseline, state is non-zero while zeroing
+  pr2_hardware_interface::DigitalOut pressure_zero_digital_out_;
+  uint8_t last_pressure_zero_command_;
+  ethercat_hardware::ExecutorPublisher<pr2_msgs::AccelerometerState> *accel_publisher_;
 
-  void convertFTDataSampleToWrench(const FTDataSample &sample, geometry_msgs::Wrench &wrench);
   static const unsigned MAX_FT_SAMPLES = 4;  
   static const unsigned NUM_FT_CHANNELS = 6;
-  static const int FT_VHALF_IDEAL = 32768; //!< Vhalf ADC measurement is ideally about (1<<16)/2
-  static const int FT_VHALF_RANGE = 300;  //!< allow vhalf to range +/- 300 from ideal
   int      ft_overload_limit_; //!< Limit on raw range of F/T input 
   uint8_t  ft_overload_flags_;  //!< Bits 0-5 set to true if raw FT input goes beyond limit
   bool     ft_disconnected_;  //!< f/t sensor may be disconnected
   bool     ft_vhalf_error_; //!< error with Vhalf reference voltage
   bool     ft_sampling_rate_error_; //!< True if FT sampling rate was incorrect
+  unsigned ft_empty_cycles_; //!< Number of consecutive cycles without new FT sample
+  unsigned max_ft_empty_cycles_; //!< More consecutive cycles without new FT sample than this is an error
   uint64_t ft_sample_count_;  //!< Counts number of ft sensor samples
   uint64_t ft_missed_samples_;  //!< Counts number of ft sensor samples that were missed
   uint64_t diag_last_ft_sample_count_; //!< F/T Sample count last time diagnostics was published
@@ -234,10 +262,25 @@ private:
   pr2_hardware_interface::ForceTorque force_torque_;
 
   //! Realtime Publisher of RAW F/T data 
-  realtime_tools::RealtimePublisher<ethercat_hardware::RawFTData> *raw_ft_publisher_;
-  realtime_tools::RealtimePublisher<geometry_msgs::WrenchStamped> *ft_publisher_;
+  ethercat_hardware::ExecutorPublisher<ethercat_hardware::RawFTData> *raw_ft_publisher_;
+  ethercat_hardware::ExecutorPublisher<geometry_msgs::WrenchStamped> *ft_publisher_;
+  //! Lossless stream of every raw F/T sample, NULL unless enabled with ft_stream parameter
+  ethercat_hardware::FTSampleStream *ft_stream_;
   //pr2_hardware_interface::AnalogIn ft_analog_in_;      //!< Provides
   FTParamsInternal ft_params_;
+  //! Gain, offset, and calibration matrix of ft_params_ folded into single transform
+  ethercat_hardware::FTCalibration ft_calibration_;
+
+  void filterFT(const double (*wrenches)[NUM_FT_CHANNELS], unsigned num_samples);
+  //! True if ft_filter parameters were given
+  bool enable_ft_filter_;
+  //! Low-pass, decimation, and bias removal applied to F/T samples
+  ethercat_hardware::FTFilter ft_filter_;
+  //! Provides filtered F/T data to controllers, alongside unfiltered force_torque_ 
+  pr2_hardware_interface::ForceTorque filtered_force_torque_;
+  //! Controllers set this to non-zero to tare filtered F/T data, state is non-zero while taring
+  pr2_hardware_interface::DigitalOut ft_tare_digital_out_;
+  uint8_t last_ft_tare_command_;
 
   bool enable_pressure_sensor_;
   bool enable_ft_sensor_;
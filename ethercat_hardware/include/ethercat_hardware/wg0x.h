@@ -38,9 +38,10 @@
 #include "ethercat_hardware/ethercat_device.h"
 #include "ethercat_hardware/motor_model.h"
 #include "ethercat_hardware/motor_heating_model.h"
-#include "realtime_tools/realtime_publisher.h"
+#include "ethercat_hardware/publisher_executor.h"
 #include "ethercat_hardware/wg_mailbox.h"
 #include "ethercat_hardware/wg_eeprom.h"
+#include "ethercat_hardware/encoder_velocity_estimator.h"
 
 #include <boost/shared_ptr.hpp>
 
@@ -194,6 +195,43 @@ struct WG0XCommand
   uint8_t checksum_;
 }__attribute__ ((__packed__));
 
+/*!
+ * \brief Scale factors that convert WG0X status into actuator state.
+ *
+ * Factors only depend on actuator and board configuration, so they are computed once 
+ * in WG0X::initialize(), and unpacking a status is a short series of multiplies and adds.
+ * Current and voltage scales stay single precision so currents and voltage match the 
+ * per-cycle calculation exactly; positions and efforts can differ in the last bit.
+ */
+struct WG0XConversionPlan
+{
+  WG0XConversionPlan();
+  void build(const WG0XActuatorInfo &actuator_info, const WG0XConfigInfo &config_info, double max_current);
+
+  //! Fills in position, calibration edges, currents, efforts, voltage, and max effort of state
+  inline void convert(const WG0XStatus &status, pr2_hardware_interface::ActuatorState &state) const
+  {
+    state.position_ = double(status.encoder_count_) * position_scale_ - state.zero_offset_;
+    state.last_calibration_rising_edge_ = double(status.last_calibration_rising_edge_) * position_scale_;
+    state.last_calibration_falling_edge_ = double(status.last_calibration_falling_edge_) * position_scale_;
+    float executed_current = status.programmed_current_ * current_scale_;
+    float measured_current = status.measured_current_ * current_scale_;
+    state.last_executed_current_ = executed_current;
+    state.last_measured_current_ = measured_current;
+    state.last_executed_effort_ = executed_current * effort_per_amp_;
+    state.last_measured_effort_ = measured_current * effort_per_amp_;
+    state.motor_voltage_ = status.motor_voltage_ * voltage_scale_;
+    state.max_effort_ = max_effort_;
+  }
+
+  double position_scale_;     //!< Radians per encoder count
+  float current_scale_;       //!< Amps per raw current value
+  double effort_per_amp_;     //!< Nm of actuator effort per amp of motor current
+  float voltage_scale_;       //!< Volts per raw motor voltage value
+  double max_effort_;         //!< Nm
+};
+
+
 struct MbxDiagnostics 
 {
   MbxDiagnostics();
@@ -238,6 +276,7 @@ public:
   WG0X();
   virtual ~WG0X();
 
+  virtual int preInitialize(bool allow_unprogrammed);
   virtual int initialize(pr2_hardware_interface::HardwareInterface *, bool allow_unprogrammed=true);
 
   void packCommand(unsigned char *buffer, bool halt, bool reset);
@@ -269,6 +308,14 @@ protected:
 
   pr2_hardware_interface::Actuator actuator_;
   pr2_hardware_interface::DigitalOut digital_out_;
+  WG0XConversionPlan conversion_;
+
+  ethercat_hardware::EncoderVelocityEstimator velocity_estimator_;
+  /*!
+   * Multi-sample velocity estimate, provided alongside actuator state as AnalogIn named 
+   * <actuator name>_velocity_estimate : [counts/s (like encoder_velocity_), rad/s (like velocity_), window in samples]
+   */
+  pr2_hardware_interface::AnalogIn velocity_estimate_analog_in_;
 
   enum
   {
@@ -323,6 +370,12 @@ protected:
   enum AppRamStatus { APP_RAM_PRESENT=1, APP_RAM_MISSING=2, APP_RAM_NOT_APPLICABLE=3 };
   AppRamStatus app_ram_status_; 
   bool readAppRam(EthercatCom *com, double &zero_offset);
+
+  // Device configuration read over mailbox by preInitialize()
+  bool pre_initialized_;
+  MotorHeatingModelParametersEepromConfig heating_config_;
+  bool app_ram_valid_;         //!< True if zero offset was stored in application ram
+  double app_ram_zero_offset_;
   bool writeAppRam(EthercatCom *com, double zero_offset);
 
   bool verifyState(WG0XStatus *this_status, WG0XStatus *prev_status);
@@ -136,7 +136,14 @@ struct SyncMan {
 
 namespace wg_util
 {
+/*!
+ * \brief Computes checksum used by WG0X devices for commands, status, and mailbox data.
+ * Buffers of at least CHECKSUM_BLOCK_MIN_LENGTH bytes are processed 8 bytes at a time.
+ */
 unsigned computeChecksum(void const *data, unsigned length);
+//! Reference checksum, one byte at a time, continuing from given checksum
+unsigned computeChecksumBytewise(void const *data, unsigned length, unsigned checksum=0x42);
+static const unsigned CHECKSUM_BLOCK_MIN_LENGTH = 16;
 unsigned int rotateRight8(unsigned in);
 };
 
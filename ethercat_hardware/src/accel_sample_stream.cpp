@@ -0,0 +1,65 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/accel_sample_stream.h"
+
+namespace ethercat_hardware
+{
+
+// Full scale of range 0,1,2 is +/-2g,4g,8g for 10bit value
+const double AccelSample::SCALE[4] = {
+  9.81 / double(1<<8),
+  9.81 / double(1<<7),
+  9.81 / double(1<<6),
+  9.81 / double(1<<5),
+};
+
+
+void AccelSampleStreamTraits::appendSample(Message &msg, uint64_t sample_count, const Sample &sample)
+{
+  msg.samples.resize(msg.samples.size() + 1);
+  ethercat_hardware::RawAccelDataSample &msg_sample(msg.samples.back());
+  msg_sample.sample_count = sample_count;
+  msg_sample.range = sample.range();
+  sample.decode(msg_sample.x, msg_sample.y, msg_sample.z);
+}
+
+
+void AccelSampleStreamTraits::finishBatch(Message &msg, uint64_t overflow_count)
+{
+  // Samples lost from stream, hardware misses show up as gaps in sample_count
+  msg.missed_samples = overflow_count;
+}
+
+}; // end namespace ethercat_hardware
@@ -0,0 +1,177 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/cycle_deadline_monitor.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace ethercat_hardware
+{
+
+const char *CycleDeadlineMonitor::phaseName(unsigned phase)
+{
+  static const char *names[NUM_PHASES] = {"Pack command", "Txandrx", "Unpack state", "Publish", "Update", "Cycle period"};
+  return (phase < NUM_PHASES) ? names[phase] : "Unknown";
+}
+
+
+CycleDeadlineMonitor::CycleDeadlineMonitor(unsigned history) : 
+  state_(RECORDING), history_(history ? history : 1), next_(0), filled_(0), post_remaining_(0),
+  freeze_streak_(0), freeze_overrun_(0.0), post_cycles_(0), last_start_(0.0)
+{
+  memset(&stats_, 0, sizeof(stats_));
+  reason_[0] = '\0';
+}
+
+
+void CycleDeadlineMonitor::setDeadline(unsigned phase, double deadline)
+{
+  if (phase < NUM_PHASES)
+  {
+    stats_.phases_[phase].deadline_ = deadline;
+  }
+}
+
+
+void CycleDeadlineMonitor::setFreezeThresholds(unsigned streak, double overrun, unsigned post_cycles)
+{
+  freeze_streak_ = streak;
+  freeze_overrun_ = overrun;
+  post_cycles_ = std::min(post_cycles, unsigned(history_.size() / 2));
+}
+
+
+void CycleDeadlineMonitor::record(double start, const double times[NUM_PHASES])
+{
+  CycleRecord record;
+  record.cycle_ = stats_.cycles_++;
+  record.start_ = start;
+  for (unsigned i = 0; i < NUM_PHASES; ++i)
+  {
+    record.times_[i] = times[i];
+  }
+  record.times_[UPDATE] = times[PACK] + times[TXANDRX] + times[UNPACK] + times[PUBLISH];
+  record.times_[PERIOD] = (record.cycle_ > 0) ? (start - last_start_) : 0.0;
+  last_start_ = start;
+  record.overrun_mask_ = 0;
+
+  // Check deadlines, and whether this cycle should trigger a capture
+  int trigger_phase = -1;
+  for (unsigned i = 0; i < NUM_PHASES; ++i)
+  {
+    PhaseStats &phase(stats_.phases_[i]);
+    double overrun = record.times_[i] - phase.deadline_;
+    if ((phase.deadline_ <= 0.0) || (overrun <= 0.0))
+    {
+      phase.streak_ = 0;
+      continue;
+    }
+    record.overrun_mask_ |= (1 << i);
+    ++phase.overruns_;
+    ++phase.streak_;
+    if (overrun > phase.longest_overrun_)
+      phase.longest_overrun_ = overrun;
+    if (phase.streak_ > phase.longest_streak_)
+      phase.longest_streak_ = phase.streak_;
+
+    if ((trigger_phase < 0) && 
+        (((freeze_streak_ > 0) && (phase.streak_ == freeze_streak_)) ||
+         ((freeze_overrun_ > 0.0) && (overrun > freeze_overrun_))))
+    {
+      trigger_phase = i;
+      if (state_.load(boost::memory_order_relaxed) == RECORDING)
+      {
+        snprintf(reason_, sizeof(reason_), "%s overran %.1fus deadline by %.1fus at cycle %llu (%u consecutive)",
+                 phaseName(i), phase.deadline_ * 1e6, overrun * 1e6, (unsigned long long) record.cycle_, phase.streak_);
+      }
+    }
+  }
+
+  int state = state_.load(boost::memory_order_acquire);
+  if (state == FROZEN)
+  {
+    return;
+  }
+
+  history_[next_] = record;
+  next_ = (next_ + 1) % history_.size();
+  if (filled_ < history_.size())
+    ++filled_;
+
+  if (state == RECORDING)
+  {
+    if (trigger_phase >= 0)
+    {
+      post_remaining_ = post_cycles_;
+      state = TRIGGERED;
+      state_.store(TRIGGERED, boost::memory_order_relaxed);
+    }
+  }
+  else if (post_remaining_ > 0)
+  {
+    --post_remaining_;
+  }
+
+  if ((state == TRIGGERED) && (post_remaining_ == 0))
+  {
+    ++stats_.captures_;
+    state_.store(FROZEN, boost::memory_order_release);
+  }
+}
+
+
+bool CycleDeadlineMonitor::takeCapture(std::vector<CycleRecord> &records, std::string &reason)
+{
+  if (state_.load(boost::memory_order_acquire) != FROZEN)
+  {
+    return false;
+  }
+
+  records.clear();
+  unsigned size = history_.size();
+  unsigned first = (next_ + size - filled_) % size;
+  for (unsigned i = 0; i < filled_; ++i)
+  {
+    records.push_back(history_[(first + i) % size]);
+  }
+  reason = reason_;
+
+  filled_ = 0;
+  state_.store(RECORDING, boost::memory_order_release);
+  return true;
+}
+
+}
@@ -0,0 +1,182 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/cyclic_table.h"
+#include "ethercat_hardware/ethercat_device.h"
+#include "ethercat_hardware/wg05.h"
+#include "ethercat_hardware/wg06.h"
+#include "ethercat_hardware/wg021.h"
+#include "ethercat_hardware/wg014.h"
+#include "ethercat_hardware/ek1122.h"
+
+#include <typeinfo>
+#include <string.h>
+
+namespace ethercat_hardware
+{
+
+template <class Device>
+static void addEntry(std::vector<CyclicEntry<Device> > &entries, Device *device, unsigned slave, unsigned offset)
+{
+  CyclicEntry<Device> entry;
+  entry.device_ = device;
+  entry.slave_ = slave;
+  entry.offset_ = offset;
+  entry.size_ = device->command_size_ + device->status_size_;
+  entries.push_back(entry);
+}
+
+
+/*!
+ * \brief Packs commands of one device type.  
+ * Calling Device::packCommand() by qualified name skips virtual dispatch.
+ */
+template <class Device>
+static inline void packEntries(const std::vector<CyclicEntry<Device> > &entries, unsigned char *buffer, 
+                               bool halt, bool reset, unsigned reset_state, unsigned cycles_per_halt_release)
+{
+  for (typename std::vector<CyclicEntry<Device> >::const_iterator it = entries.begin(); it != entries.end(); ++it)
+  {
+    bool halt_device = halt || ((it->slave_ * cycles_per_halt_release + 1) < reset_state);
+    it->device_->Device::packCommand(buffer + it->offset_, halt_device, reset);
+  }
+}
+
+
+template <class Device>
+static inline bool unpackEntries(const std::vector<CyclicEntry<Device> > &entries, 
+                                 unsigned char *this_buffer, unsigned char *prev_buffer, bool keep_copy)
+{
+  bool success = true;
+  for (typename std::vector<CyclicEntry<Device> >::const_iterator it = entries.begin(); it != entries.end(); ++it)
+  {
+    success &= it->device_->Device::unpackState(this_buffer + it->offset_, prev_buffer + it->offset_);
+    if (keep_copy)
+    {
+      memcpy(prev_buffer + it->offset_, this_buffer + it->offset_, it->size_);
+    }
+  }
+  return success;
+}
+
+
+// Virtual calls for devices of unknown type
+static inline void packEntries(const std::vector<CyclicEntry<EthercatDevice> > &entries, unsigned char *buffer, 
+                               bool halt, bool reset, unsigned reset_state, unsigned cycles_per_halt_release)
+{
+  for (std::vector<CyclicEntry<EthercatDevice> >::const_iterator it = entries.begin(); it != entries.end(); ++it)
+  {
+    bool halt_device = halt || ((it->slave_ * cycles_per_halt_release + 1) < reset_state);
+    it->device_->packCommand(buffer + it->offset_, halt_device, reset);
+  }
+}
+
+
+static inline bool unpackEntries(const std::vector<CyclicEntry<EthercatDevice> > &entries, 
+                                 unsigned char *this_buffer, unsigned char *prev_buffer, bool keep_copy)
+{
+  bool success = true;
+  for (std::vector<CyclicEntry<EthercatDevice> >::const_iterator it = entries.begin(); it != entries.end(); ++it)
+  {
+    success &= it->device_->unpackState(this_buffer + it->offset_, prev_buffer + it->offset_);
+    if (keep_copy)
+    {
+      memcpy(prev_buffer + it->offset_, this_buffer + it->offset_, it->size_);
+    }
+  }
+  return success;
+}
+
+
+void CyclicTable::clear()
+{
+  wg05_.clear();
+  wg06_.clear();
+  wg021_.clear();
+  wg014_.clear();
+  ek1122_.clear();
+  generic_.clear();
+}
+
+
+void CyclicTable::add(EthercatDevice *device, unsigned slave, unsigned offset)
+{
+  // Only exact type matches can skip virtual dispatch, a class derived from a known 
+  // type might override packCommand() or unpackState()
+  const std::type_info &type(typeid(*device));
+  if (type == typeid(WG05))
+    addEntry(wg05_, static_cast<WG05*>(device), slave, offset);
+  else if (type == typeid(WG06))
+    addEntry(wg06_, static_cast<WG06*>(device), slave, offset);
+  else if (type == typeid(WG021))
+    addEntry(wg021_, static_cast<WG021*>(device), slave, offset);
+  else if (type == typeid(WG014))
+    addEntry(wg014_, static_cast<WG014*>(device), slave, offset);
+  else if (type == typeid(EK1122))
+    addEntry(ek1122_, static_cast<EK1122*>(device), slave, offset);
+  else
+    addEntry(generic_, device, slave, offset);
+}
+
+
+void CyclicTable::packCommands(unsigned char *buffer, bool halt, bool reset, unsigned reset_state, unsigned cycles_per_halt_release)
+{
+  packEntries(wg05_, buffer, halt, reset, reset_state, cycles_per_halt_release);
+  packEntries(wg06_, buffer, halt, reset, reset_state, cycles_per_halt_release);
+  packEntries(wg021_, buffer, halt, reset, reset_state, cycles_per_halt_release);
+  packEntries(wg014_, buffer, halt, reset, reset_state, cycles_per_halt_release);
+  packEntries(ek1122_, buffer, halt, reset, reset_state, cycles_per_halt_release);
+  packEntries(generic_, buffer, halt, reset, reset_state, cycles_per_halt_release);
+}
+
+
+bool CyclicTable::unpackStates(unsigned char *this_buffer, unsigned char *prev_buffer, bool keep_copy)
+{
+  bool success = true;
+  success &= unpackEntries(wg05_, this_buffer, prev_buffer, keep_copy);
+  success &= unpackEntries(wg06_, this_buffer, prev_buffer, keep_copy);
+  success &= unpackEntries(wg021_, this_buffer, prev_buffer, keep_copy);
+  success &= unpackEntries(wg014_, this_buffer, prev_buffer, keep_copy);
+  success &= unpackEntries(ek1122_, this_buffer, prev_buffer, keep_copy);
+  success &= unpackEntries(generic_, this_buffer, prev_buffer, keep_copy);
+  return success;
+}
+
+
+unsigned CyclicTable::numTyped() const
+{
+  return wg05_.size() + wg06_.size() + wg021_.size() + wg014_.size() + ek1122_.size();
+}
+
+}
@@ -0,0 +1,155 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/encoder_velocity_estimator.h"
+
+#include <math.h>
+
+namespace ethercat_hardware
+{
+
+//! Difference of encoder counts, done unsigned so it is well defined when count wraps around
+static inline int32_t countDiff(int32_t a, int32_t b)
+{
+  return int32_t(uint32_t(a) - uint32_t(b));
+}
+
+EncoderVelocityEstimator::EncoderVelocityEstimator(double noise_band, double max_window)
+{
+  configure(noise_band, max_window);
+  reset();
+}
+
+
+void EncoderVelocityEstimator::configure(double noise_band, double max_window)
+{
+  noise_band_ = noise_band;
+  max_window_ = max_window;
+}
+
+
+void EncoderVelocityEstimator::reset()
+{
+  newest_ = 0;
+  num_samples_ = 0;
+  velocity_ = 0.0;
+  window_ = 0;
+}
+
+
+double EncoderVelocityEstimator::update(int32_t count, uint32_t timestamp)
+{
+  if (num_samples_ > 0)
+  {
+    // Repeated sample (status was not refreshed) adds nothing, keep previous estimate.
+    // Time going backwards means device was reset, and history is not usable.
+    int32_t dt = int32_t(timestamp - timestamps_[newest_]);
+    if (dt == 0)
+    {
+      return velocity_;
+    }
+    if (dt < 0)
+    {
+      reset();
+    }
+  }
+
+  newest_ = (newest_ + 1) % MAX_SAMPLES;
+  counts_[newest_] = count;
+  timestamps_[newest_] = timestamp;
+  if (num_samples_ < MAX_SAMPLES)
+  {
+    ++num_samples_;
+  }
+  if (num_samples_ < 2)
+  {
+    velocity_ = 0.0;
+    window_ = 0;
+    return velocity_;
+  }
+
+  // All positions and times are relative to newest sample, so wrap-around does not matter.
+  // Grow window one sample at a time, until line through newest and oldest sample of window 
+  // misses some sample in between by more than noise band.
+  unsigned best_window = 1;
+  for (unsigned n = 2; n < num_samples_; ++n)
+  {
+    unsigned oldest = (newest_ + MAX_SAMPLES - n) % MAX_SAMPLES;
+    double dx = double(countDiff(counts_[oldest], count));
+    double dt = double(int32_t(timestamps_[oldest] - timestamp)) * 1e-6;
+    if (-dt > max_window_)
+    {
+      break;
+    }
+    double v = dx / dt;
+
+    bool fits = true;
+    for (unsigned j = 1; j < n; ++j)
+    {
+      unsigned i = (newest_ + MAX_SAMPLES - j) % MAX_SAMPLES;
+      double x = double(countDiff(counts_[i], count));
+      double t = double(int32_t(timestamps_[i] - timestamp)) * 1e-6;
+      if (fabs(x - v * t) > noise_band_)
+      {
+        fits = false;
+        break;
+      }
+    }
+    if (!fits)
+    {
+      break;
+    }
+    best_window = n;
+  }
+
+  // End-fit slope is off by up to one count over window, least-squares fit over 
+  // same window averages quantization error of all samples
+  double sum_t = 0.0, sum_x = 0.0, sum_tt = 0.0, sum_tx = 0.0;
+  for (unsigned j = 0; j <= best_window; ++j)
+  {
+    unsigned i = (newest_ + MAX_SAMPLES - j) % MAX_SAMPLES;
+    double x = double(countDiff(counts_[i], count));
+    double t = double(int32_t(timestamps_[i] - timestamp)) * 1e-6;
+    sum_t += t;
+    sum_x += x;
+    sum_tt += t * t;
+    sum_tx += t * x;
+  }
+  double n = best_window + 1;
+  velocity_ = (n * sum_tx - sum_t * sum_x) / (n * sum_tt - sum_t * sum_t);
+  window_ = best_window;
+  return velocity_;
+}
+
+}
@@ -344,6 +344,9 @@ EthercatDevice::EthercatDevice() : use_ros_(true)
   sh_ = NULL;
   command_size_ = 0;
   status_size_ = 0;
+  exchange_divisor_ = 1;
+  process_data_offset_ = 0;
+  cycle_period_ = 0.001;
   newDiagnosticsIndex_ = 0;
 
   int error = pthread_mutex_init(&newDiagnosticsIndexLock_, NULL);
@@ -395,6 +398,15 @@ void EthercatDevice::collectDiagnostics(EthercatCom *com)
 }
 
 
+bool EthercatDevice::resetDetected()
+{
+  pthread_mutex_lock(&newDiagnosticsIndexLock_);
+  bool reset = deviceDiagnostics[newDiagnosticsIndex_].resetDetected();
+  pthread_mutex_unlock(&newDiagnosticsIndexLock_);
+  return reset;
+}
+
+
 int EthercatDevice::readWriteData(EthercatCom *com, EtherCAT_SlaveHandler *sh,  EC_UINT address, void* buffer, EC_UINT length, AddrMode addrMode)
 {
   unsigned char *p = (unsigned char *)buffer;
@@ -551,6 +563,8 @@ void EthercatDevice::ethercatDiagnostics(diagnostic_updater::DiagnosticStatusWra
   newDiag.publish(d, numPorts);
 
   pthread_mutex_unlock(&newDiagnosticsIndexLock_);
+
+  d.addf("Exchange divisor", "%u", exchange_divisor_);
 }
 
 
@@ -33,6 +33,7 @@
  *********************************************************************/
 
 #include <vector>
+#include <set>
 
 #include "ethercat_hardware/ethercat_hardware.h"
 
@@ -41,14 +42,17 @@
 #include <dll/ethercat_device_addressed_telegram.h>
 
 #include <sstream>
+#include <fstream>
 
 #include <net/if.h>
 #include <sys/ioctl.h>
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
-#include <boost/regex.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/filesystem.hpp>
+
+#include <tinyxml.h>
 
 EthercatHardwareDiagnostics::EthercatHardwareDiagnostics() :
 
@@ -59,6 +63,13 @@ EthercatHardwareDiagnostics::EthercatHardwareDiagnostics() :
   reset_motors_service_count_(0), 
   halt_motors_service_count_(0),
   halt_motors_error_count_(0),
+  reconnected_devices_(0),
+  shared_memory_enabled_(false),
+  shared_memory_latency_(0),
+  shared_memory_max_latency_(0),
+  shared_memory_stale_cycles_(0),
+  shared_memory_torn_reads_(0),
+  deadline_stats_(),
   motors_halted_(false),
   motors_halted_reason_("")
 {
@@ -75,8 +86,11 @@ void EthercatHardwareDiagnostics::resetMaxTiming()
 
 EthercatHardware::EthercatHardware(const std::string& name) :
   hw_(0), node_(ros::NodeHandle(name)),
-  ni_(0), this_buffer_(0), prev_buffer_(0), buffer_size_(0), halt_motors_(true), reset_state_(0), 
+  ni_(0), chain_cache_buffer_size_(0), next_pre_initialize_(0), deadline_captures_saved_(0), this_buffer_(0), prev_buffer_(0), buffers_(0), buffer_size_(0), exchange_cycle_(0), halt_motors_(true), reset_state_(0), 
+  cycle_period_(0.001), cycles_per_halt_release_(2),
   max_pd_retries_(10),
+  reconnect_reset_devices_(false),
+  reconnected_devices_(0),
   diagnostics_publisher_(node_), 
   motor_publisher_(node_, "motors_halted", 1, true), 
   device_loader_("ethercat_hardware", "EthercatDevice")
@@ -176,7 +190,7 @@ void EthercatHardware::init(char *interface, bool allow_unprogrammed)
     exit(EXIT_FAILURE);
   }
 
-  int num_ethercat_devices_ = al_->get_num_slaves();
+  num_ethercat_devices_ = al_->get_num_slaves();
   if (num_ethercat_devices_ == 0)
   {
     ROS_FATAL("Unable to locate any slaves");
@@ -210,7 +224,13 @@ void EthercatHardware::init(char *interface, bool allow_unprogrammed)
     slave_handles.push_back(sh);
   }
 
+  // Index available device drivers by product code, so each slave is a single lookup
+  ros::WallTime phase_start(ros::WallTime::now());
+  indexDeviceClasses();
+  double discovery_time = (ros::WallTime::now() - phase_start).toSec();
+
   // Configure EtherCAT slaves
+  phase_start = ros::WallTime::now();
   BOOST_FOREACH(EtherCAT_SlaveHandler *sh, slave_handles)
   {    
     unsigned slave = sh->get_station_address()-1;
@@ -220,13 +240,32 @@ void EthercatHardware::init(char *interface, bool allow_unprogrammed)
       sleep(1);
       exit(EXIT_FAILURE);
     }
-    buffer_size_ += slaves_[slave]->command_size_ + slaves_[slave]->status_size_;
   }
 
   // Configure any non-ethercat slaves (appends devices to slaves_ vector)
   loadNonEthercatDevices();
 
+  // Until devices are initialized, all are exchanged every cycle in order of ring position.
+  // If chain matches cache of previous run, devices instead start with layout and exchange 
+  // rates they ended up with last time, so process data does not need to be rebuilt after initialization.
+  chain_cache_file_.clear();
+  node_.getParam("chain_cache_file", chain_cache_file_);
+  bool warm_restart = loadChainCache();
+  sortExchangeOrder();
+  constructInExchangeOrder();
+  if (warm_restart && !chainCacheMatchesLayout())
+  {
+    // Chain is still in INIT, so it can be constructed again with default layout
+    ROS_WARN("Logical address map differs from chain cache '%s', doing full startup", chain_cache_file_.c_str());
+    forgetChainCache();
+    warm_restart = false;
+    sortExchangeOrder();
+    constructInExchangeOrder();
+  }
+  double construction_time = (ros::WallTime::now() - phase_start).toSec();
+
   // Move slave from INIT to PREOP
+  phase_start = ros::WallTime::now();
   BOOST_FOREACH(EtherCAT_SlaveHandler *sh, slave_handles)
   {
     changeState(sh,EC_PREOP_STATE);
@@ -244,6 +283,7 @@ void EthercatHardware::init(char *interface, bool allow_unprogrammed)
   {
     changeState(sh,EC_OP_STATE);
   }
+  double transition_time = (ros::WallTime::now() - phase_start).toSec();
 
   // Allocate buffers to send and receive commands
   buffers_ = new unsigned char[2 * buffer_size_];
@@ -262,38 +302,117 @@ void EthercatHardware::init(char *interface, bool allow_unprogrammed)
   // prev_buffer should contain valid status data when update function is first used
   memcpy(prev_buffer_, this_buffer_, buffer_size_);
 
+  { // Period of realtime loop.  Device models, filters, and timeouts are derived from this.
+    static const double MIN_CYCLE_PERIOD = 0.0002;  // 5kHz
+    static const double MAX_CYCLE_PERIOD = 0.01;    // 100Hz
+    double cycle_period = 0.001;
+    node_.getParam("cycle_period", cycle_period);
+    if ((cycle_period < MIN_CYCLE_PERIOD) || (cycle_period > MAX_CYCLE_PERIOD))
+    {
+      ROS_FATAL("Invalid cycle period (%f), must be between %f and %f seconds", cycle_period, MIN_CYCLE_PERIOD, MAX_CYCLE_PERIOD);
+      sleep(1);
+      exit(EXIT_FAILURE);
+    }
+    cycle_period_ = cycle_period;
+    // Wait 2ms between releasing each device from halt
+    cycles_per_halt_release_ = std::max(1, int(0.002 / cycle_period_ + 0.5));
+    for (unsigned int slave = 0; slave < slaves_.size(); ++slave)
+    {
+      slaves_[slave]->cycle_period_ = cycle_period_;
+    }
+  }
+
+  { // Deadlines of realtime cycle, zero disables check of a phase
+    using ethercat_hardware::CycleDeadlineMonitor;
+    ros::NodeHandle deadline_node(node_, "deadline");
+    static const char *params[CycleDeadlineMonitor::NUM_PHASES] = {"pack", "txandrx", "unpack", "publish", "update", "period"};
+    double defaults[CycleDeadlineMonitor::NUM_PHASES] = {0.0, 0.0, 0.0, 0.0, cycle_period_, 2.0 * cycle_period_};
+    for (unsigned phase = 0; phase < CycleDeadlineMonitor::NUM_PHASES; ++phase)
+    {
+      double deadline = defaults[phase];
+      deadline_node.getParam(params[phase], deadline);
+      deadline_monitor_.setDeadline(phase, deadline);
+    }
+    int freeze_streak = 3;
+    double freeze_overrun = cycle_period_;
+    int post_cycles = 20;
+    deadline_node.getParam("freeze_streak", freeze_streak);
+    deadline_node.getParam("freeze_overrun", freeze_overrun);
+    deadline_node.getParam("post_trigger_cycles", post_cycles);
+    deadline_node.getParam("capture_dir", deadline_capture_dir_);
+    deadline_monitor_.setFreezeThresholds(std::max(0, freeze_streak), freeze_overrun, std::max(0, post_cycles));
+  }
+
   // Create pr2_hardware_interface::HardwareInterface
   hw_ = new pr2_hardware_interface::HardwareInterface();
   hw_->current_time_ = ros::Time::now();
   last_published_ = hw_->current_time_;
 
+  // Number of threads used to read device configuration. 
+  // With more than one thread, mailbox transactions of different devices are in flight 
+  // at the same time, instead of each device waiting for the one before it.
+  int initialization_threads = 1;
+  node_.getParam("initialization_threads", initialization_threads);
+  unsigned num_threads = std::max(1, std::min(initialization_threads, int(slaves_.size())));
+
+  startup_start_ = ros::WallTime::now();
+  startup_timeline_.assign(slaves_.size(), StartupTimeline());
+  if (num_threads > 1)
+  {
+    preInitializeSlaves(allow_unprogrammed, num_threads);
+  }
+
   // Initialize slaves
-  //set<string> actuator_names;
+  // Registration with hardware interface is done one device at a time, in ring order
   for (unsigned int slave = 0; slave < slaves_.size(); ++slave)
   {
+    startup_timeline_[slave].initialize_start_ = startupTime();
     if (slaves_[slave]->initialize(hw_, allow_unprogrammed) < 0)
     {
-      EtherCAT_SlaveHandler *sh = slaves_[slave]->sh_;
-      if (sh != NULL)
-      {
-        ROS_FATAL("Unable to initialize slave #%d, product code: %d, revision: %d, serial: %d",
-                  slave, sh->get_product_code(), sh->get_revision(), sh->get_serial());
-        sleep(1);
-      } 
-      else 
-      {
-        ROS_FATAL("Unable to initialize slave #%d", slave);
-      }
-      exit(EXIT_FAILURE);
+      initializeFailed(slave);
     }
+    startup_timeline_[slave].initialize_end_ = startupTime();
   }
+  double initialization_time = startupTime();
+  reportStartupTimeline(num_threads);
+
+  // Devices may have disabled optional sensors during initialization, 
+  // if so, rebuild process data without the unused regions
+  phase_start = ros::WallTime::now();
+  bool rebuilt = relayoutProcessData();
+  transition_time += (ros::WallTime::now() - phase_start).toSec();
+
+  {
+    std::vector<unsigned> offsets;
+    for (unsigned slave = 0; slave < slaves_.size(); ++slave)
+    {
+      offsets.push_back(slaves_[slave]->process_data_offset_);
+    }
+    snapshot_.setLayout(offsets);
+  }
+  if (warm_restart)
+  {
+    if (!rebuilt)
+    {
+      ROS_INFO("Warm restart : reused process data layout of previous run (%u bytes)", buffer_size_);
+    }
+    else
+    {
+      ROS_WARN("Warm restart : process data layout differs from previous run, chain was rebuilt");
+    }
+  }
+  saveChainCache();
+
+  ROS_INFO("Startup time : plugin discovery %.1fms, construction %.1fms, state transitions %.1fms, device initialization %.1fms",
+           discovery_time * 1e3, construction_time * 1e3, transition_time * 1e3, initialization_time * 1e3);
 
 
   { // Initialization is now complete. Reduce timeout of EtherCAT txandrx for better realtime performance
     // Allow timeout to be configured at program load time with rosparam.  
     // This will allow tweaks for systems with different realtime performace
     static const int MAX_TIMEOUT = 100000;   // 100ms = 100,000us
-    static const int DEFAULT_TIMEOUT = 20000; // default to timeout to 20000us = 20ms
+    // default to timeout of 20 cycles : 20000us = 20ms for 1kHz loop
+    const int DEFAULT_TIMEOUT = int(20 * cycle_period_ * 1e6 + 0.5);
     int timeout;
     if (!node_.getParam("realtime_socket_timeout", timeout))
     {
@@ -321,6 +440,11 @@ void EthercatHardware::init(char *interface, bool allow_unprogrammed)
     // This is needed because lowering the txandrx timeout makes it more likely that a 
     // performance hickup in network or OS causes will cause the motors to halt.
     //
+    // Replies that arrive after timeout are dropped by EML, and process data is re-sent.
+    // On a system where replies are often slightly late, raise realtime_socket_timeout 
+    // so they are still accepted, rather than raising max_pd_retries.  Either way, 
+    // timeout * max_pd_retries is the time before motors halt and is limited below.
+    //
     // If number of retries is not specified, use a formula that allows 100ms of dropped packets
     int max_pd_retries = MAX_TIMEOUT / timeout;  // timeout is in nanoseconds : 20msec = 20000usec 
     static const int MAX_RETRIES=50, MIN_RETRIES=1;
@@ -340,6 +464,25 @@ void EthercatHardware::init(char *interface, bool allow_unprogrammed)
     max_pd_retries_ = max_pd_retries;
   }
 
+  // Devices that are reset can be brought back by diagnostics thread, without restarting driver
+  reconnect_reset_devices_ = false;
+  node_.getParam("reconnect_reset_devices", reconnect_reset_devices_);
+
+  // Optional shared memory mirror of actuators, for controllers running in another process
+  std::string shared_memory_name;
+  if (node_.getParam("shared_memory_name", shared_memory_name) && !shared_memory_name.empty())
+  {
+    double command_timeout = 0.01;
+    node_.getParam("shared_memory_command_timeout", command_timeout);
+    if (!shared_memory_.initialize(shared_memory_name, hw_, cycle_period_, command_timeout))
+    {
+      ROS_FATAL("Could not create shared memory interface '%s'", shared_memory_name.c_str());
+      sleep(1);
+      exit(EXIT_FAILURE);
+    }
+    diagnostics_.shared_memory_enabled_ = true;
+  }
+
   diagnostics_publisher_.initialize(interface_, buffer_size_, slaves_, num_ethercat_devices_, timeout_, max_pd_retries_);
 }
 
@@ -464,6 +607,14 @@ void EthercatHardwareDiagnosticsPublisher::publishDiagnostics()
   status_.add("Motors halted", diagnostics_.motors_halted_ ? "true" : "false");
   status_.addf("EtherCAT devices (expected)", "%d", num_ethercat_devices_); 
   status_.addf("EtherCAT devices (current)",  "%d", diagnostics_.device_count_); 
+  status_.addf("Devices reconnected", "%u", diagnostics_.reconnected_devices_);
+  if (diagnostics_.shared_memory_enabled_)
+  {
+    status_.addf("Shared memory command latency (cycles)", "%u", diagnostics_.shared_memory_latency_);
+    status_.addf("Shared memory max command latency (cycles)", "%u", diagnostics_.shared_memory_max_latency_);
+    status_.addf("Shared memory stale command cycles", "%llu", (unsigned long long) diagnostics_.shared_memory_stale_cycles_);
+    status_.addf("Shared memory torn command reads", "%llu", (unsigned long long) diagnostics_.shared_memory_torn_reads_);
+  }
   ethernet_interface_info_.publishDiagnostics(status_);
   //status_.addf("Reset state", "%d", reset_state_);
 
@@ -485,6 +636,29 @@ void EthercatHardwareDiagnosticsPublisher::publishDiagnostics()
 
   status_.addf("EtherCAT Process Data txandrx errors", "%d", diagnostics_.txandrx_errors_);
 
+  { // Deadline overruns of realtime cycle
+    using ethercat_hardware::CycleDeadlineMonitor;
+    const CycleDeadlineMonitor::Stats &stats(diagnostics_.deadline_stats_);
+    for (unsigned phase = 0; phase < CycleDeadlineMonitor::NUM_PHASES; ++phase)
+    {
+      const CycleDeadlineMonitor::PhaseStats &p(stats.phases_[phase]);
+      if (p.deadline_ > 0.0)
+      {
+        status_.addf(std::string(CycleDeadlineMonitor::phaseName(phase)) + " deadline overruns", 
+                     "%llu of %llu cycles (deadline %.1fus, longest overrun %.1fus, longest streak %u)", 
+                     (unsigned long long) p.overruns_, (unsigned long long) stats.cycles_, 
+                     p.deadline_ * 1e6, p.longest_overrun_ * 1e6, p.longest_streak_);
+      }
+    }
+    status_.addf("Cycle deadline captures", "%u", stats.captures_);
+  }
+
+  {
+    ethercat_hardware::PublisherExecutor &executor(ethercat_hardware::PublisherExecutor::instance());
+    status_.addf("Publisher threads", "%u", executor.numThreads());
+    status_.addf("Publisher queue overflows", "%llu", (unsigned long long)executor.droppedCount());
+  }
+
   status_.addf("Reset motors service count", "%d", diagnostics_.reset_motors_service_count_);
   status_.addf("Halt motors service count", "%d", diagnostics_.halt_motors_service_count_);
   status_.addf("Halt motors error count", "%d", diagnostics_.halt_motors_error_count_);
@@ -536,11 +710,9 @@ void EthercatHardwareDiagnosticsPublisher::publishDiagnostics()
   diagnostic_array_.status.push_back(status_);
 
   // Also, collect diagnostic statuses of all EtherCAT device
-  unsigned char *current = diagnostics_buffer_;
   for (unsigned int s = 0; s < slaves_.size(); ++s)
   {
-    slaves_[s]->multiDiagnostics(diagnostic_array_.status, current);
-    current += slaves_[s]->command_size_ + slaves_[s]->status_size_;
+    slaves_[s]->multiDiagnostics(diagnostic_array_.status, diagnostics_buffer_ + slaves_[s]->process_data_offset_);
   }
 
   // Publish status of each EtherCAT device
@@ -553,11 +725,6 @@ void EthercatHardware::update(bool reset, bool halt)
   // Update current time
   ros::Time update_start_time(ros::Time::now());
 
-  unsigned char *this_buffer, *prev_buffer;
-
-  // Convert HW Interface commands to MCB-specific buffers
-  this_buffer = this_buffer_;
-
   if (halt)
   {
     ++diagnostics_.halt_motors_service_count_;
@@ -566,7 +733,7 @@ void EthercatHardware::update(bool reset, bool halt)
 
   // Resetting devices should clear device errors and release devices from halt.
   // To reduce load on power system, release devices from halt, one at a time 
-  const unsigned CYCLES_PER_HALT_RELEASE = 2; // Wait two cycles between releasing each device
+  const unsigned CYCLES_PER_HALT_RELEASE = cycles_per_halt_release_; // Wait 2ms between releasing each device
   if (reset)
   {
     ++diagnostics_.reset_motors_service_count_;
@@ -584,13 +751,29 @@ void EthercatHardware::update(bool reset, bool halt)
     diagnostics_.pd_error_ = false;
   }
 
-  for (unsigned int s = 0; s < slaves_.size(); ++s)
+  // Slower exchange groups are only serviced on cycles that are a multiple of their divisor.
+  // Reset requests are remembered until devices of a group are next exchanged.
+  unsigned num_groups = 0;
+  for (unsigned g = 0; g < exchange_groups_.size(); ++g)
+  {
+    ExchangeGroup &group(exchange_groups_[g]);
+    group.reset_pending_ |= reset_devices;
+    if ((exchange_cycle_ % group.divisor_) == 0)
+    {
+      num_groups = g + 1;
+    }
+  }
+  unsigned exchange_size = num_groups ? exchange_groups_[num_groups-1].size_ : 0;
+
+  // Take latest commands of out-of-process controllers, for actuators they claimed
+  shared_memory_.readCommands();
+
+  // Pack the command structures into the EtherCAT buffer
+  // Disable the motor if they are halted or coming out of reset
+  for (unsigned g = 0; g < num_groups; ++g)
   {
-    // Pack the command structures into the EtherCAT buffer
-    // Disable the motor if they are halted or coming out of reset
-    bool halt_device = halt_motors_ || ((s*CYCLES_PER_HALT_RELEASE+1) < reset_state_);
-    slaves_[s]->packCommand(this_buffer, halt_device, reset_devices);
-    this_buffer += slaves_[s]->command_size_ + slaves_[s]->status_size_;
+    ExchangeGroup &group(exchange_groups_[g]);
+    group.table_.packCommands(this_buffer_, halt_motors_, group.reset_pending_, reset_state_, CYCLES_PER_HALT_RELEASE);
   }
 
   // Transmit process data
@@ -598,7 +781,7 @@ void EthercatHardware::update(bool reset, bool halt)
   diagnostics_.pack_command_acc_((txandrx_start_time-update_start_time).toSec());
 
   // Send/receive device proccess data
-  bool success = txandrx_PD(buffer_size_, this_buffer_, max_pd_retries_);
+  bool success = (exchange_size == 0) || txandrx_PD(exchange_size, this_buffer_, max_pd_retries_);
 
   ros::Time txandrx_end_time(ros::Time::now());  // Also begining of unpack_state 
   diagnostics_.txandrx_acc_((txandrx_end_time - txandrx_start_time).toSec());
@@ -613,17 +796,19 @@ void EthercatHardware::update(bool reset, bool halt)
   }
   else
   {
+    // Slower groups copy latest data into published buffer while unpacking
+    snapshot_.beginUpdate();
+
     // Convert status back to HW Interface
-    this_buffer = this_buffer_;
-    prev_buffer = prev_buffer_;
-    for (unsigned int s = 0; s < slaves_.size(); ++s)
+    for (unsigned g = 0; g < num_groups; ++g)
     {
-      if (!slaves_[s]->unpackState(this_buffer, prev_buffer) && !reset_devices)
+      ExchangeGroup &group(exchange_groups_[g]);
+      // Buffers are swapped every cycle, but slower devices are not exchanged every cycle.
+      // Keep a copy of latest data in both buffers so next exchange sees it as previous data.
+      if (!group.table_.unpackStates(this_buffer_, prev_buffer_, group.divisor_ > 1) && !group.reset_pending_)
       {
         haltMotors(true /*error*/, "device error");
       }
-      this_buffer += slaves_[s]->command_size_ + slaves_[s]->status_size_;
-      prev_buffer += slaves_[s]->command_size_ + slaves_[s]->status_size_;
     }
     
     if (reset_state_)
@@ -632,6 +817,17 @@ void EthercatHardware::update(bool reset, bool halt)
     unsigned char *tmp = this_buffer_;
     this_buffer_ = prev_buffer_;
     prev_buffer_ = tmp;
+    snapshot_.publish(prev_buffer_, buffer_size_);
+    shared_memory_.writeState();
+  }
+
+  for (unsigned g = 0; g < num_groups; ++g)
+  {
+    exchange_groups_[g].reset_pending_ = false;
+  }
+  if (!exchange_groups_.empty() && (++exchange_cycle_ >= exchange_groups_.back().divisor_))
+  {
+    exchange_cycle_ = 0;
   }
 
   ros::Time unpack_end_time;
@@ -654,6 +850,13 @@ void EthercatHardware::update(bool reset, bool halt)
   {
     ros::Time publish_end_time(ros::Time::now());  
     diagnostics_.publish_acc_((publish_end_time - unpack_end_time).toSec());
+
+    double times[ethercat_hardware::CycleDeadlineMonitor::NUM_PHASES] = {0};
+    times[ethercat_hardware::CycleDeadlineMonitor::PACK] = (txandrx_start_time - update_start_time).toSec();
+    times[ethercat_hardware::CycleDeadlineMonitor::TXANDRX] = (txandrx_end_time - txandrx_start_time).toSec();
+    times[ethercat_hardware::CycleDeadlineMonitor::UNPACK] = (unpack_end_time - txandrx_end_time).toSec();
+    times[ethercat_hardware::CycleDeadlineMonitor::PUBLISH] = (publish_end_time - unpack_end_time).toSec();
+    deadline_monitor_.record(update_start_time.toSec(), times);
   }
 }
 
@@ -689,6 +892,7 @@ void EthercatHardware::updateAccMax(double &max, const accumulator_set<double, s
   max = std::max(max, extract_result<tag::max>(acc));
 }
 
+
 void EthercatHardware::publishDiagnostics()
 {
   // Update max timing values
@@ -702,6 +906,13 @@ void EthercatHardware::publishDiagnostics()
   diagnostics_.input_thread_is_stopped_ = bool(ni_->is_stopped);
 
   diagnostics_.motors_halted_ = halt_motors_;
+  diagnostics_.deadline_stats_ = deadline_monitor_.stats();
+  diagnostics_.reconnected_devices_ = reconnected_devices_.load(boost::memory_order_relaxed);
+
+  diagnostics_.shared_memory_latency_ = shared_memory_.latencyCycles();
+  diagnostics_.shared_memory_max_latency_ = shared_memory_.maxLatencyCycles();
+  diagnostics_.shared_memory_stale_cycles_ = shared_memory_.staleCycles();
+  diagnostics_.shared_memory_torn_reads_ = shared_memory_.tornReads();
 
   // Pass diagnostic data to publisher thread
   diagnostics_publisher_.publish(this_buffer_, diagnostics_);
@@ -715,10 +926,31 @@ void EthercatHardware::publishDiagnostics()
 }
 
 
+void EthercatHardware::indexDeviceClasses()
+{
+  device_classes_.clear();
+  std::vector<std::string> classes = device_loader_.getDeclaredClasses();
+  BOOST_FOREACH(const std::string &class_name, classes)
+  {
+    // Product ID is part of class name after last '/', or whole name if there is no package
+    std::string::size_type slash = class_name.rfind('/');
+    std::string product_id = (slash == std::string::npos) ? class_name : class_name.substr(slash + 1);
+
+    DeviceClassMap::iterator existing = device_classes_.find(product_id);
+    if (existing != device_classes_.end())
+    {
+      ROS_ERROR("Found more than 1 EtherCAT driver for device with product code : %s", product_id.c_str());
+      ROS_ERROR("First class name = '%s'.  Second class name = '%s'",
+                existing->second.c_str(), class_name.c_str());
+    }
+    device_classes_[product_id] = class_name;
+  }
+}
+
+
 boost::shared_ptr<EthercatDevice>
 EthercatHardware::configSlave(EtherCAT_SlaveHandler *sh)
 {
-  static int start_address = 0x00010000;
   boost::shared_ptr<EthercatDevice> p;
   unsigned product_code = sh->get_product_code();
   unsigned serial = sh->get_serial();
@@ -753,27 +985,15 @@ EthercatHardware::configSlave(EtherCAT_SlaveHandler *sh)
   //
   //
   // Unfortunately, we don't know which ROS package that a particular driver is defined in.
-  // To account for this, we search through the list of class names, one-by-one and find string where
-  // last part of string matches product ID of device.  
-  stringstream class_name_regex_str;
-  class_name_regex_str << "(.*/)?" << product_code;
-  boost::regex class_name_regex(class_name_regex_str.str(), boost::regex::extended);
-
-  std::vector<std::string> classes = device_loader_.getDeclaredClasses();
+  // To account for this, indexDeviceClasses() indexes all class names by their last part, 
+  // which should be the product ID of device.  
   std::string matching_class_name;
-
-  BOOST_FOREACH(const std::string &class_name, classes)
+  stringstream product_code_str;
+  product_code_str << product_code;
+  DeviceClassMap::const_iterator match = device_classes_.find(product_code_str.str());
+  if (match != device_classes_.end())
   {
-    if (regex_match(class_name, class_name_regex))
-    {
-      if (matching_class_name.size() != 0)
-      {
-        ROS_ERROR("Found more than 1 EtherCAT driver for device with product code : %d", product_code);
-        ROS_ERROR("First class name = '%s'.  Second class name = '%s'",
-                  class_name.c_str(), matching_class_name.c_str());
-      }
-      matching_class_name = class_name;
-    }
+    matching_class_name = match->second;
   }
 
   if (matching_class_name.size() != 0)
@@ -803,9 +1023,9 @@ EthercatHardware::configSlave(EtherCAT_SlaveHandler *sh)
       ROS_ERROR("Unable to load plugin for slave #%d, product code: %u (0x%X), serial: %u (0x%X), revision: %d (0x%X)",
                 slave, product_code, product_code, serial, serial, revision, revision);
       ROS_ERROR("Possible classes:");
-      BOOST_FOREACH(const std::string &class_name, classes)
+      for (DeviceClassMap::const_iterator it = device_classes_.begin(); it != device_classes_.end(); ++it)
       {
-        ROS_ERROR("  %s", class_name.c_str());
+        ROS_ERROR("  %s", it->second.c_str());
       }
       
       // TODO, use default plugin for ethercat devices that have no driver. 
@@ -813,11 +1033,6 @@ EthercatHardware::configSlave(EtherCAT_SlaveHandler *sh)
     }                
   }
 
-  if (p != NULL)
-  {
-    p->construct(sh, start_address);
-  }
-
   return p;
 }
 
@@ -852,6 +1067,481 @@ public:
   XmlRpcValue::ValueStruct &getMap() {return *_value.asStruct;}
 };
 
+/*!
+ * \brief Orders slaves by exchange divisor, keeping ring order for slaves with same divisor.
+ *
+ * Divisors are rounded up so each one is a multiple of all smaller divisors.  
+ * This keeps devices that are due on any cycle contiguous at start of process data.
+ */
+void EthercatHardware::sortExchangeOrder()
+{
+  std::set<unsigned> divisors;
+  for (unsigned s = 0; s < slaves_.size(); ++s)
+  {
+    divisors.insert(slaves_[s]->exchange_divisor_);
+  }
+
+  exchange_order_.clear();
+  unsigned previous_divisor = 1;
+  BOOST_FOREACH(unsigned divisor, divisors)
+  {
+    unsigned effective_divisor = ((divisor + previous_divisor - 1) / previous_divisor) * previous_divisor;
+    for (unsigned s = 0; s < slaves_.size(); ++s)
+    {
+      if (slaves_[s]->exchange_divisor_ == divisor)
+      {
+        if (effective_divisor != divisor)
+        {
+          ROS_WARN("Exchange divisor of device #%02d rounded up from %u to %u", s, divisor, effective_divisor);
+          slaves_[s]->exchange_divisor_ = effective_divisor;
+        }
+        exchange_order_.push_back(s);
+      }
+    }
+    previous_divisor = effective_divisor;
+  }
+}
+
+
+/*!
+ * \brief Constructs EtherCAT slaves with logical addresses in exchange order, then builds exchange groups.
+ * Logical addresses follow exchange order, so slower devices end up at end of process data.
+ */
+void EthercatHardware::constructInExchangeOrder()
+{
+  int start_address = PROCESS_DATA_START_ADDRESS;
+  BOOST_FOREACH(unsigned slave, exchange_order_)
+  {
+    if (slave < num_ethercat_devices_)
+    {
+      EtherCAT_SlaveHandler *sh = em_->get_slave_handler(EC_FixedStationAddress(slave + 1));
+      slaves_[slave]->construct(sh, start_address);
+    }
+  }
+  buildExchangeGroups();
+}
+
+
+/*!
+ * \brief Assigns process data offsets to slaves in exchange order, and groups slaves by divisor.
+ */
+void EthercatHardware::buildExchangeGroups()
+{
+  exchange_groups_.clear();
+  unsigned offset = 0;
+  for (unsigned i = 0; i < exchange_order_.size(); ++i)
+  {
+    EthercatDevice *device = slaves_[exchange_order_[i]].get();
+    if (exchange_groups_.empty() || (exchange_groups_.back().divisor_ != device->exchange_divisor_))
+    {
+      ExchangeGroup group;
+      group.divisor_ = device->exchange_divisor_;
+      group.reset_pending_ = false;
+      exchange_groups_.push_back(group);
+    }
+    device->process_data_offset_ = offset;
+    exchange_groups_.back().table_.add(device, exchange_order_[i], offset);
+    offset += device->command_size_ + device->status_size_;
+    exchange_groups_.back().end_ = i + 1;
+    exchange_groups_.back().size_ = offset;
+  }
+  buffer_size_ = offset;
+  exchange_cycle_ = 0;
+}
+
+
+double EthercatHardware::startupTime() const
+{
+  return (ros::WallTime::now() - startup_start_).toSec();
+}
+
+
+void EthercatHardware::initializeFailed(unsigned slave)
+{
+  EtherCAT_SlaveHandler *sh = slaves_[slave]->sh_;
+  if (sh != NULL)
+  {
+    ROS_FATAL("Unable to initialize slave #%d, product code: %d, revision: %d, serial: %d",
+              slave, sh->get_product_code(), sh->get_revision(), sh->get_serial());
+    sleep(1);
+  } 
+  else 
+  {
+    ROS_FATAL("Unable to initialize slave #%d", slave);
+  }
+  exit(EXIT_FAILURE);
+}
+
+
+void EthercatHardware::preInitializeThreadFunc(bool allow_unprogrammed)
+{
+  while (true)
+  {
+    unsigned slave;
+    {
+      boost::mutex::scoped_lock lock(pre_initialize_mutex_);
+      if (next_pre_initialize_ >= slaves_.size())
+      {
+        return;
+      }
+      slave = next_pre_initialize_++;
+    }
+
+    StartupTimeline &timeline(startup_timeline_[slave]);
+    timeline.pre_initialize_start_ = startupTime();
+    timeline.pre_initialize_result_ = slaves_[slave]->preInitialize(allow_unprogrammed);
+    timeline.pre_initialize_end_ = startupTime();
+  }
+}
+
+
+/*!
+ * \brief Reads configuration of all devices using a pool of threads.
+ *
+ * Each thread takes next device in ring order and runs its mailbox transactions, 
+ * so while one device is busy answering a request, frames for other devices are already on the wire.
+ */
+void EthercatHardware::preInitializeSlaves(bool allow_unprogrammed, unsigned num_threads)
+{
+  next_pre_initialize_ = 0;
+  boost::thread_group threads;
+  for (unsigned i = 0; i < num_threads; ++i)
+  {
+    threads.create_thread(boost::bind(&EthercatHardware::preInitializeThreadFunc, this, allow_unprogrammed));
+  }
+  threads.join_all();
+
+  for (unsigned int slave = 0; slave < slaves_.size(); ++slave)
+  {
+    if (startup_timeline_[slave].pre_initialize_result_ < 0)
+    {
+      initializeFailed(slave);
+    }
+  }
+}
+
+
+void EthercatHardware::reportStartupTimeline(unsigned num_threads)
+{
+  for (unsigned int slave = 0; slave < slaves_.size(); ++slave)
+  {
+    const StartupTimeline &t(startup_timeline_[slave]);
+    if (num_threads > 1)
+    {
+      ROS_DEBUG("Device #%02d : read configuration %7.1fms - %7.1fms, initialize %7.1fms - %7.1fms", slave,
+                t.pre_initialize_start_ * 1e3, t.pre_initialize_end_ * 1e3, t.initialize_start_ * 1e3, t.initialize_end_ * 1e3);
+    }
+    else
+    {
+      ROS_DEBUG("Device #%02d : initialize %7.1fms - %7.1fms", slave, t.initialize_start_ * 1e3, t.initialize_end_ * 1e3);
+    }
+  }
+
+  double total = startupTime();
+  double longest = 0.0;
+  unsigned longest_slave = 0;
+  for (unsigned int slave = 0; slave < slaves_.size(); ++slave)
+  {
+    const StartupTimeline &t(startup_timeline_[slave]);
+    double duration = (t.pre_initialize_end_ - t.pre_initialize_start_) + (t.initialize_end_ - t.initialize_start_);
+    if (duration > longest)
+    {
+      longest = duration;
+      longest_slave = slave;
+    }
+  }
+  ROS_INFO("Initialized %d devices in %.1fms using %d thread%s, slowest device #%02d took %.1fms", 
+           int(slaves_.size()), total * 1e3, num_threads, (num_threads > 1) ? "s" : "", longest_slave, longest * 1e3);
+}
+
+
+/*!
+ * \brief Rebuilds process data layout of chain if any device has changed its data regions or exchange rate.
+ *
+ * FMMU and sync manager configuration can only be changed outside of SAFEOP/OP, so the whole 
+ * chain is moved back to PREOP, every device is re-constructed with fresh logical addresses, 
+ * and chain is brought back up to OP.  Process data buffers are reallocated for new size.
+ * \return true if process data layout was rebuilt
+ */
+bool EthercatHardware::relayoutProcessData()
+{
+  bool changed = false;
+  for (unsigned int slave = 0; slave < slaves_.size(); ++slave)
+  {
+    if (slaves_[slave]->processDataLayoutChanged())
+    {
+      changed = true;
+    }
+  }
+
+  std::vector<unsigned> old_exchange_order(exchange_order_);
+  sortExchangeOrder();
+  if (!changed && (exchange_order_ == old_exchange_order))
+  {
+    // Logical addresses stay the same, only exchange rates may differ
+    buildExchangeGroups();
+    return false;
+  }
+
+  std::vector<EtherCAT_SlaveHandler*> slave_handles;
+  BOOST_FOREACH(unsigned slave, exchange_order_)
+  {
+    if (slaves_[slave]->sh_ != NULL)
+    {
+      slave_handles.push_back(slaves_[slave]->sh_);
+    }
+  }
+
+  BOOST_FOREACH(EtherCAT_SlaveHandler *sh, slave_handles)
+  {
+    changeState(sh,EC_PREOP_STATE);
+  }
+
+  unsigned old_buffer_size = buffer_size_;
+  constructInExchangeOrder();
+
+  BOOST_FOREACH(EtherCAT_SlaveHandler *sh, slave_handles)
+  {
+    changeState(sh,EC_SAFEOP_STATE);
+  }
+  BOOST_FOREACH(EtherCAT_SlaveHandler *sh, slave_handles)
+  {
+    changeState(sh,EC_OP_STATE);
+  }
+
+  delete[] buffers_;
+  buffers_ = new unsigned char[2 * buffer_size_];
+  this_buffer_ = buffers_;
+  prev_buffer_ = buffers_ + buffer_size_;
+
+  // Motors are still disabled, collect status data for new layout
+  memset(this_buffer_, 0, 2 * buffer_size_);
+  if (!txandrx_PD(buffer_size_, this_buffer_, 20))
+  {
+    ROS_FATAL("No communication with devices after changing process data layout");
+    sleep(1);
+    exit(EXIT_FAILURE);
+  }
+  memcpy(prev_buffer_, this_buffer_, buffer_size_);
+
+  ROS_INFO("Process data size changed from %u to %u bytes", old_buffer_size, buffer_size_);
+  BOOST_FOREACH(const ExchangeGroup &group, exchange_groups_)
+  {
+    ROS_INFO("  exchanged every %u cycle(s) : %u bytes", group.divisor_, group.size_);
+  }
+  return true;
+}
+
+
+static bool getUnsignedAttribute(TiXmlElement *elt, const char *name, unsigned &value)
+{
+  const char *attr = elt->Attribute(name);
+  if (attr == NULL)
+  {
+    return false;
+  }
+  char *endptr;
+  value = strtoul(attr, &endptr, 0);
+  return (*attr != '\0') && (*endptr == '\0');
+}
+
+
+static void setUnsignedAttribute(TiXmlElement *elt, const char *name, unsigned value)
+{
+  std::ostringstream os;
+  os << value;
+  elt->SetAttribute(name, os.str());
+}
+
+
+/*!
+ * \brief Loads description of chain saved by previous run, and checks it against chain found by this run.
+ *
+ * If every EtherCAT device has same product code, serial and revision as in cache, devices are told to 
+ * expect process data layout and exchange rate they had at end of previous run.
+ * Device configuration is still read from each device, since EEPROM and application ram 
+ * contents can change between runs without changing anything in chain scan.
+ * \return true if cache matches chain
+ */
+bool EthercatHardware::loadChainCache()
+{
+  chain_cache_.clear();
+  chain_cache_buffer_size_ = 0;
+  if (chain_cache_file_.empty())
+  {
+    return false;
+  }
+
+  if (!boost::filesystem::exists(chain_cache_file_))
+  {
+    ROS_INFO("Chain cache '%s' does not exist, doing full startup", chain_cache_file_.c_str());
+    return false;
+  }
+
+  TiXmlDocument xml;
+  TiXmlElement *chain_elt = NULL;
+  if (!xml.LoadFile(chain_cache_file_) || ((chain_elt = xml.RootElement()) == NULL))
+  {
+    ROS_WARN("Unable to parse XML in chain cache '%s'", chain_cache_file_.c_str());
+    return false;
+  }
+
+  const char *version = chain_elt->Attribute("version");
+  if ((version == NULL) || (strcmp(version, "1") != 0))
+  {
+    ROS_WARN("Unknown version of chain cache '%s'", chain_cache_file_.c_str());
+    return false;
+  }
+
+  const char *interface = chain_elt->Attribute("interface");
+  if ((interface == NULL) || (interface_ != interface))
+  {
+    ROS_INFO("Chain cache '%s' is for different interface, doing full startup", chain_cache_file_.c_str());
+    return false;
+  }
+
+  unsigned buffer_size;
+  if (!getUnsignedAttribute(chain_elt, "buffer_size", buffer_size))
+  {
+    ROS_WARN("Invalid process data size in chain cache '%s'", chain_cache_file_.c_str());
+    return false;
+  }
+
+  std::vector<ChainCacheEntry> entries;
+  for (TiXmlElement *elt = chain_elt->FirstChildElement("slave"); elt != NULL; elt = elt->NextSiblingElement("slave"))
+  {
+    ChainCacheEntry entry;
+    unsigned position;
+    bool success = true;
+    success &= getUnsignedAttribute(elt, "position", position);
+    success &= (position == entries.size());
+    success &= getUnsignedAttribute(elt, "product_code", entry.product_code_);
+    success &= getUnsignedAttribute(elt, "serial", entry.serial_);
+    success &= getUnsignedAttribute(elt, "revision", entry.revision_);
+    success &= getUnsignedAttribute(elt, "layout", entry.layout_);
+    success &= getUnsignedAttribute(elt, "exchange_divisor", entry.exchange_divisor_);
+    success &= getUnsignedAttribute(elt, "offset", entry.process_data_offset_);
+    if (!success || (entry.exchange_divisor_ < 1))
+    {
+      ROS_WARN("Invalid device entry in chain cache '%s'", chain_cache_file_.c_str());
+      return false;
+    }
+    entries.push_back(entry);
+  }
+
+  if (entries.size() != num_ethercat_devices_)
+  {
+    ROS_INFO("Chain has %d devices, but chain cache has %d, doing full startup", 
+             int(num_ethercat_devices_), int(entries.size()));
+    return false;
+  }
+
+  for (unsigned slave = 0; slave < num_ethercat_devices_; ++slave)
+  {
+    const ChainCacheEntry &entry(entries[slave]);
+    EtherCAT_SlaveHandler *sh = em_->get_slave_handler(EC_FixedStationAddress(slave + 1));
+    if ((sh->get_product_code() != entry.product_code_) || 
+        (sh->get_serial() != entry.serial_) || 
+        (sh->get_revision() != entry.revision_))
+    {
+      ROS_INFO("Device #%02d does not match chain cache, doing full startup", slave);
+      return false;
+    }
+  }
+
+  for (unsigned slave = 0; slave < num_ethercat_devices_; ++slave)
+  {
+    slaves_[slave]->expectProcessDataLayout(entries[slave].layout_);
+    slaves_[slave]->exchange_divisor_ = entries[slave].exchange_divisor_;
+  }
+  chain_cache_ = entries;
+  chain_cache_buffer_size_ = buffer_size;
+  return true;
+}
+
+
+/*!
+ * \brief Returns true if logical address of each device, and process data size, are same as in chain cache
+ */
+bool EthercatHardware::chainCacheMatchesLayout() const
+{
+  if (buffer_size_ != chain_cache_buffer_size_)
+  {
+    return false;
+  }
+  for (unsigned slave = 0; slave < chain_cache_.size(); ++slave)
+  {
+    if (chain_cache_[slave].process_data_offset_ != slaves_[slave]->process_data_offset_)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/*!
+ * \brief Drops layout and exchange rates taken from chain cache, so devices start as if there was no cache.
+ */
+void EthercatHardware::forgetChainCache()
+{
+  for (unsigned slave = 0; slave < chain_cache_.size(); ++slave)
+  {
+    slaves_[slave]->expectProcessDataLayout(slaves_[slave]->defaultProcessDataLayout());
+    slaves_[slave]->exchange_divisor_ = 1;
+  }
+  chain_cache_.clear();
+  chain_cache_buffer_size_ = 0;
+}
+
+
+/*!
+ * \brief Saves description of chain, so next run can verify it and start with same process data layout.
+ * Like motor heating model files, data is first written to temp file, which is then renamed.
+ */
+void EthercatHardware::saveChainCache()
+{
+  if (chain_cache_file_.empty())
+  {
+    return;
+  }
+
+  TiXmlDocument xml;
+  TiXmlDeclaration *decl = new TiXmlDeclaration( "1.0", "", "" );
+  TiXmlElement *chain_elt = new TiXmlElement("ethercat_chain");
+  chain_elt->SetAttribute("version", "1");
+  chain_elt->SetAttribute("interface", interface_);
+  setUnsignedAttribute(chain_elt, "buffer_size", buffer_size_);
+  for (unsigned slave = 0; slave < num_ethercat_devices_; ++slave)
+  {
+    const EthercatDevice *device = slaves_[slave].get();
+    TiXmlElement *elt = new TiXmlElement("slave");
+    setUnsignedAttribute(elt, "position", slave);
+    setUnsignedAttribute(elt, "product_code", device->sh_->get_product_code());
+    setUnsignedAttribute(elt, "serial", device->sh_->get_serial());
+    setUnsignedAttribute(elt, "revision", device->sh_->get_revision());
+    setUnsignedAttribute(elt, "layout", device->processDataLayout());
+    setUnsignedAttribute(elt, "exchange_divisor", device->exchange_divisor_);
+    setUnsignedAttribute(elt, "offset", device->process_data_offset_);
+    chain_elt->LinkEndChild(elt);
+  }
+  xml.LinkEndChild(decl);
+  xml.LinkEndChild(chain_elt);
+
+  std::string tmp_filename = chain_cache_file_ + ".tmp";
+  if (!xml.SaveFile(tmp_filename))
+  {
+    ROS_WARN("Could not save chain cache '%s'", tmp_filename.c_str());
+    return;
+  }
+  if (rename(tmp_filename.c_str(), chain_cache_file_.c_str()) != 0)
+  {
+    int error = errno;
+    ROS_WARN("Problem renaming '%s' to '%s' : %s", tmp_filename.c_str(), chain_cache_file_.c_str(), strerror(error));
+  }
+}
+
+
 void EthercatHardware::loadNonEthercatDevices()
 {
   // non-EtherCAT device drivers are descibed via struct named "non_ethercat_devices"
@@ -951,6 +1641,253 @@ void EthercatHardware::collectDiagnostics()
     boost::shared_ptr<EthercatDevice> d(slaves_[i]);
     d->collectDiagnostics(oob_com_);
   }
+
+  if (reconnect_reset_devices_)
+  {
+    reconnectResetSlaves();
+  }
+
+  std::vector<ethercat_hardware::CycleDeadlineMonitor::CycleRecord> records;
+  std::string reason;
+  if (deadline_monitor_.takeCapture(records, reason))
+  {
+    saveDeadlineCapture(records, reason);
+  }
+}
+
+
+/*!
+ * \brief Reports cycles captured around deadline overrun, and saves them to capture directory if one is set.
+ */
+void EthercatHardware::saveDeadlineCapture(const std::vector<ethercat_hardware::CycleDeadlineMonitor::CycleRecord> &records, 
+                                           const std::string &reason)
+{
+  using ethercat_hardware::CycleDeadlineMonitor;
+  ++deadline_captures_saved_;
+
+  // Slowest update in capture, usually the spike that caused trigger
+  unsigned worst = 0;
+  for (unsigned i = 1; i < records.size(); ++i)
+  {
+    if (records[i].times_[CycleDeadlineMonitor::UPDATE] > records[worst].times_[CycleDeadlineMonitor::UPDATE])
+      worst = i;
+  }
+  if (!records.empty())
+  {
+    const CycleDeadlineMonitor::CycleRecord &r(records[worst]);
+    ROS_WARN("Cycle deadline capture : %s.  Slowest cycle %llu : pack %.1fus, txandrx %.1fus, unpack %.1fus, publish %.1fus, period %.1fus", 
+             reason.c_str(), (unsigned long long) r.cycle_, 
+             r.times_[CycleDeadlineMonitor::PACK] * 1e6, r.times_[CycleDeadlineMonitor::TXANDRX] * 1e6,
+             r.times_[CycleDeadlineMonitor::UNPACK] * 1e6, r.times_[CycleDeadlineMonitor::PUBLISH] * 1e6,
+             r.times_[CycleDeadlineMonitor::PERIOD] * 1e6);
+  }
+
+  if (deadline_capture_dir_.empty())
+  {
+    return;
+  }
+
+  std::ostringstream filename;
+  filename << deadline_capture_dir_ << "/deadline_capture_" << deadline_captures_saved_ << ".csv";
+  std::ofstream out(filename.str().c_str());
+  if (!out)
+  {
+    ROS_ERROR("Could not write cycle deadline capture '%s'", filename.str().c_str());
+    return;
+  }
+  out << "# " << reason << endl;
+  out << "cycle,start";
+  for (unsigned phase = 0; phase < CycleDeadlineMonitor::NUM_PHASES; ++phase)
+  {
+    out << "," << CycleDeadlineMonitor::phaseName(phase) << " (us)";
+  }
+  out << ",overrun_mask" << endl;
+  out.precision(15);
+  for (unsigned i = 0; i < records.size(); ++i)
+  {
+    const CycleDeadlineMonitor::CycleRecord &r(records[i]);
+    out << r.cycle_ << "," << r.start_;
+    for (unsigned phase = 0; phase < CycleDeadlineMonitor::NUM_PHASES; ++phase)
+    {
+      out << "," << r.times_[phase] * 1e6;
+    }
+    out << "," << r.overrun_mask_ << endl;
+  }
+  ROS_INFO("Saved cycle deadline capture to '%s'", filename.str().c_str());
+}
+
+
+/*!
+ * \brief Brings devices that were reset back into process data exchange, while rest of chain keeps running.
+ *
+ * A device that was reset or power cycled loses its node address, sync manager and FMMU configuration, 
+ * and falls back to INIT state.  Process data exchanges fail until it is back in OP, 
+ * so motors are halted, and stay halted until motors are reset.
+ */
+void EthercatHardware::reconnectResetSlaves()
+{
+  for (unsigned slave = 0; slave < num_ethercat_devices_; ++slave)
+  {
+    if (!slaves_[slave]->resetDetected())
+    {
+      continue;
+    }
+
+    ros::WallTime start(ros::WallTime::now());
+    if (reconnectSlave(slave))
+    {
+      reconnected_devices_.fetch_add(1, boost::memory_order_relaxed);
+      ROS_WARN("Device #%02d was reset, reconnected in %.1fms", slave, (ros::WallTime::now() - start).toSec() * 1e3);
+      // Refresh diagnostics so device is not reconnected again next time
+      slaves_[slave]->collectDiagnostics(oob_com_);
+    }
+    else
+    {
+      ROS_ERROR("Device #%02d was reset, could not reconnect it.  Will try again.", slave);
+    }
+  }
+}
+
+
+/*!
+ * \brief Moves one device to new state, using out-of-band communication.
+ *
+ * Writes AL control register of device, then polls its AL status until device reports new state.
+ * Telegrams go out with process data of realtime loop, so rest of chain keeps cycling.
+ * EtherCAT library's view of device state is not changed.
+ * \return true if device reached new state
+ */
+bool EthercatHardware::oobChangeState(EtherCAT_SlaveHandler *sh, EC_State new_state)
+{
+  static const EC_UINT AL_CONTROL_ADDR = 0x0120;
+  static const EC_UINT AL_STATUS_ADDR = 0x0130;
+  static const unsigned AL_STATUS_SIZE = 6;         // AL status, reserved, AL status code
+  static const uint8_t AL_STATUS_ERROR = 0x10;
+  static const double TIMEOUT = 1.0;
+
+  EC_Logic *logic = EC_Logic::instance();
+
+  { // Request new state
+    unsigned char control[2] = {uint8_t(new_state), 0};
+    NPWR_Telegram npwr_telegram(logic->get_idx(),
+                                sh->get_station_address(),
+                                AL_CONTROL_ADDR,
+                                logic->get_wkc(),
+                                sizeof(control),
+                                control);
+    EC_Ethernet_Frame frame(&npwr_telegram);
+    if (!oob_com_->txandrx(&frame) || (npwr_telegram.get_wkc() != 1))
+    {
+      ROS_WARN("Could not request state %d from slave #%d", new_state, sh->get_station_address()-1);
+      return false;
+    }
+  }
+
+  // Poll AL status until device reports new state
+  unsigned char al_status[AL_STATUS_SIZE];
+  ros::WallTime start(ros::WallTime::now());
+  while (true)
+  {
+    NPRD_Telegram nprd_telegram(logic->get_idx(),
+                                sh->get_station_address(),
+                                AL_STATUS_ADDR,
+                                logic->get_wkc(),
+                                sizeof(al_status),
+                                al_status);
+    EC_Ethernet_Frame frame(&nprd_telegram);
+    if (oob_com_->txandrx(&frame) && (nprd_telegram.get_wkc() == 1))
+    {
+      if (al_status[0] & AL_STATUS_ERROR)
+      {
+        ROS_WARN("Slave #%d refused state %d, AL status code 0x%04X", 
+                 sh->get_station_address()-1, new_state, al_status[4] | (al_status[5] << 8));
+        return false;
+      }
+      if ((al_status[0] & 0x0F) == new_state)
+      {
+        return true;
+      }
+    }
+    if ((ros::WallTime::now() - start).toSec() > TIMEOUT)
+    {
+      ROS_WARN("Slave #%d did not reach state %d", sh->get_station_address()-1, new_state);
+      return false;
+    }
+    usleep(100);
+  }
+}
+
+
+/*!
+ * \brief Re-addresses and re-configures one reset device, and moves it back to OP state.
+ *
+ * All communication goes through out-of-band com, never directly through EtherCAT library, 
+ * since realtime loop keeps exchanging process data with rest of chain.
+ * Node address is written with positional addressing.  FMMUs and sync managers are 
+ * restored from configuration set up by construct(), while device is in INIT state.
+ * \return true if device is back in OP state
+ */
+bool EthercatHardware::reconnectSlave(unsigned slave)
+{
+  static const EC_UINT STATION_ADDRESS_ADDR = 0x0010;
+  static const EC_UINT FMMU_BASE_ADDR = 0x0600;
+  static const EC_UINT SYNC_MAN_BASE_ADDR = 0x0800;
+  EtherCAT_SlaveHandler *sh = slaves_[slave]->sh_;
+
+  uint16_t station_address = sh->get_station_address();
+  if (EthercatDevice::writeData(oob_com_, sh, STATION_ADDRESS_ADDR, &station_address, sizeof(station_address), 
+                                EthercatDevice::POSITIONAL_ADDR) != 0)
+  {
+    ROS_ERROR("Could not restore node address of device #%02d", slave);
+    return false;
+  }
+
+  // Device came back in INIT, make sure nothing was left half way through a transition
+  if (!oobChangeState(sh, EC_INIT_STATE))
+  {
+    return false;
+  }
+
+  EtherCAT_FMMU_Config *fmmu_config = sh->get_fmmu_config();
+  if ((fmmu_config != NULL) && (fmmu_config->length() > 0))
+  {
+    std::vector<unsigned char> data(fmmu_config->length());
+    fmmu_config->dump(&data[0]);
+    if (EthercatDevice::writeData(oob_com_, sh, FMMU_BASE_ADDR, &data[0], data.size(), EthercatDevice::FIXED_ADDR) != 0)
+    {
+      ROS_ERROR("Could not restore FMMUs of device #%02d", slave);
+      return false;
+    }
+  }
+
+  EtherCAT_PD_Config *pd_config = sh->get_pd_config();
+  if ((pd_config != NULL) && (pd_config->length() > 0))
+  {
+    std::vector<unsigned char> data(pd_config->length());
+    pd_config->dump(&data[0]);
+    if (EthercatDevice::writeData(oob_com_, sh, SYNC_MAN_BASE_ADDR, &data[0], data.size(), EthercatDevice::FIXED_ADDR) != 0)
+    {
+      ROS_ERROR("Could not restore sync managers of device #%02d", slave);
+      return false;
+    }
+  }
+
+  static const EC_State states[] = {EC_PREOP_STATE, EC_SAFEOP_STATE, EC_OP_STATE};
+  for (unsigned i = 0; i < sizeof(states)/sizeof(states[0]); ++i)
+  {
+    if (!oobChangeState(sh, states[i]))
+    {
+      ROS_ERROR("Could not move device #%02d to state %d", slave, states[i]);
+      return false;
+    }
+  }
+
+  if (slaves_[slave]->reconfigure(oob_com_) != 0)
+  {
+    return false;
+  }
+
+  return true;
 }
 
 
@@ -986,7 +1923,7 @@ bool EthercatHardware::txandrx_PD(unsigned buffer_size, unsigned char* buffer, u
   bool success = false;
   for (unsigned i=0; i<tries && !success; ++i) {
     // Try transmitting process data
-    success = em_->txandrx_PD(buffer_size_, this_buffer_);
+    success = em_->txandrx_PD(buffer_size, buffer);
     if (!success) {
       ++diagnostics_.txandrx_errors_;
     } 
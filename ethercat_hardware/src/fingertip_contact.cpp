@@ -0,0 +1,177 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/fingertip_contact.h"
+
+namespace ethercat_hardware
+{
+
+// From fingertip_pressure/src/fingertip_pressure/fingertip_geometry.py, 
+// after generating mirrored/translated cells and moving origin (converted to meters)
+const double FingertipContact::CELL_CENTERS[NUM_CELLS][3] = {
+  {  0.02530, -0.00400,  0.00000 }, // 0
+  {  0.01250, -0.00980, -0.01150 }, // 1
+  {  0.02775, -0.01030, -0.00925 }, // 2
+  {  0.03100, -0.01030, -0.00350 }, // 3
+  {  0.03100, -0.01030,  0.00350 }, // 4
+  {  0.02775, -0.01030,  0.00925 }, // 5
+  {  0.01250, -0.00980,  0.01150 }, // 6
+  {  0.02650, -0.01500,  0.00560 }, // 7
+  {  0.02650, -0.01500,  0.00000 }, // 8
+  {  0.02650, -0.01500, -0.00560 }, // 9
+  {  0.02050, -0.01500,  0.00560 }, // 10
+  {  0.02050, -0.01500,  0.00000 }, // 11
+  {  0.02050, -0.01500, -0.00560 }, // 12
+  {  0.01450, -0.01500,  0.00560 }, // 13
+  {  0.01450, -0.01500,  0.00000 }, // 14
+  {  0.01450, -0.01500, -0.00560 }, // 15
+  {  0.00850, -0.01500,  0.00560 }, // 16
+  {  0.00850, -0.01500,  0.00000 }, // 17
+  {  0.00850, -0.01500, -0.00560 }, // 18
+  {  0.00250, -0.01500,  0.00560 }, // 19
+  {  0.00250, -0.01500,  0.00000 }, // 20
+  {  0.00250, -0.01500, -0.00560 }, // 21
+};
+
+const double FingertipContact::FORCE_PER_UNIT[NUM_CELLS] = {
+  600, // 0 bottom
+  400, // 1 side
+  600, // 2 corner
+  600, // 3 front
+  600, // 4 front
+  600, // 5 corner
+  400, // 6 side
+  1600, 1600, 1600, 
+  1600, 1600, 1600, 
+  1600, 1600, 1600, 
+  1600, 1600, 1600, 
+  1600, 1600, 1600, 
+};
+
+
+FingertipContact::FingertipContact(int orientation) :
+  threshold_(1.0),
+  zero_samples_(10),
+  contact_(false),
+  total_force_(0.0)
+{
+  setOrientation(orientation);
+  for (unsigned i=0; i<NUM_CELLS; ++i)
+  {
+    baseline_[i] = 0.0;
+    cell_force_[i] = 0.0;
+  }
+  for (unsigned j=0; j<3; ++j)
+  {
+    centroid_[j] = 0.0;
+  }
+  zero();
+}
+
+
+void FingertipContact::setOrientation(int orientation)
+{
+  // Same as multorientation() in fingertip_geometry.py
+  double sign = (orientation < 0) ? -1.0 : 1.0;
+  for (unsigned i=0; i<NUM_CELLS; ++i)
+  {
+    centers_[i][0] = CELL_CENTERS[i][0];
+    centers_[i][1] = CELL_CENTERS[i][1] * sign;
+    centers_[i][2] = CELL_CENTERS[i][2] * sign;
+  }
+}
+
+
+void FingertipContact::zero()
+{
+  zero_count_ = 0;
+  for (unsigned i=0; i<NUM_CELLS; ++i)
+  {
+    zero_sum_[i] = 0.0;
+  }
+}
+
+
+void FingertipContact::update(const uint16_t *cells)
+{
+  if (isZeroing())
+  {
+    for (unsigned i=0; i<NUM_CELLS; ++i)
+    {
+      zero_sum_[i] += cells[i];
+    }
+    if (++zero_count_ >= zero_samples_)
+    {
+      for (unsigned i=0; i<NUM_CELLS; ++i)
+      {
+        baseline_[i] = zero_sum_[i] / zero_count_;
+      }
+    }
+  }
+
+  double total = 0.0;
+  double moment[3] = {0.0, 0.0, 0.0};
+  for (unsigned i=0; i<NUM_CELLS; ++i)
+  {
+    double force = (double(cells[i]) - baseline_[i]) / FORCE_PER_UNIT[i];
+    force = (force > 0.0) ? force : 0.0;
+    cell_force_[i] = force;
+    total += force;
+    moment[0] += force * centers_[i][0];
+    moment[1] += force * centers_[i][1];
+    moment[2] += force * centers_[i][2];
+  }
+
+  total_force_ = total;
+  contact_ = (total > threshold_) && !isZeroing();
+  if (total > 0.0)
+  {
+    for (unsigned j=0; j<3; ++j)
+    {
+      centroid_[j] = moment[j] / total;
+    }
+  }
+}
+
+
+void FingertipContact::getOutputs(double *outputs) const
+{
+  outputs[CONTACT] = contact_ ? 1.0 : 0.0;
+  outputs[TOTAL_FORCE] = total_force_;
+  outputs[CENTROID_X] = centroid_[0];
+  outputs[CENTROID_Y] = centroid_[1];
+  outputs[CENTROID_Z] = centroid_[2];
+}
+
+}; // end namespace ethercat_hardware
@@ -0,0 +1,231 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/ft_calibration.h"
+
+#include <boost/static_assert.hpp>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ethercat_hardware
+{
+
+FTCalibration::FTCalibration()
+{
+  // Default to identity transform (no gain, offset, or calibration)
+  double coeff[36];
+  double offsets[NUM_CHANNELS];
+  double gains[NUM_CHANNELS];
+  for (unsigned i=0; i<NUM_CHANNELS; ++i)
+  {
+    offsets[i] = 0.0;
+    gains[i] = 1.0;
+    for (unsigned j=0; j<NUM_CHANNELS; ++j)
+    {
+      coeff[i*NUM_CHANNELS + j] = (i==j) ? 1.0 : 0.0;
+    }
+  }
+  configure(coeff, offsets, gains, 32767);
+}
+
+
+/*!
+ * \brief Fold gain, offset, and coefficient matrix into single affine transform
+ * 
+ * The calibration matrix is based on "raw"  deltaR/R values from strain gauges
+ *
+ * Force/Torque = Coeff * ADCVoltage
+ *
+ * Coeff = RawCoeff / ( ExcitationVoltage * AmplifierGain )
+ *       = RawCoeff / ( 2.5V * AmplifierGain )
+ *
+ * ADCVoltage = Vref / 2^16 
+ *            = 2.5 / 2^16
+ * 
+ * Force/Torque =  RawCalibrationCoeff / ( ExcitationVoltage * AmplifierGain ) * (ADCValues * 2.5V/2^16)
+ *              = (RawCalibration * ADCValues) / (AmplifierGain * 2^16)
+ * 
+ * Note on hardware circuit and Vref and excitation voltage should have save value.  
+ * Thus, with Force/Torque calculation they cancel out. 
+ */
+void FTCalibration::configure(const double calibration_coeff[36], const double offsets[6], const double gains[6], 
+                              int overload_limit)
+{
+  // Force/Torque = Coeff * ((ADCValues - Offset) / (Gain * 2^16))
+  //              = M * ADCValues + b
+  for (unsigned j=0; j<NUM_CHANNELS; ++j)
+  {
+    double scale = 1.0 / (gains[j] * double(1<<16));
+    for (unsigned i=0; i<NUM_CHANNELS; ++i)
+    {
+      columns_[j][i] = calibration_coeff[i*NUM_CHANNELS + j] * scale;
+    }
+  }
+
+  for (unsigned i=0; i<NUM_CHANNELS; ++i)
+  {
+    double sum = 0.0;
+    for (unsigned j=0; j<NUM_CHANNELS; ++j)
+    {
+      sum -= columns_[j][i] * offsets[j];
+    }
+    bias_[i] = sum;
+  }
+
+  // Raw values are 16bit, so limit needs to fit in 16bits for vectorized compare
+  if (overload_limit < 0) 
+    overload_limit = 0;
+  if (overload_limit > 32767) 
+    overload_limit = 32767;
+  overload_limit_ = overload_limit;
+}
+
+
+/*!
+ * \brief Check Vhalf value of sample without using branches.
+ *
+ * Vhalf ADC measurement should be amost half the ADC reference voltage
+ * For a 16bit ADC the Vhalf value should be about (1<<16)/2
+ * If Vhalf value is not close to this, this could mean 1 of 2 things:
+ *   1. WG035 electronics are damaged some-how 
+ *   2. WG035 is not present or disconnected gripper MCB 
+ * When WG035 MCB is not present the DATA line floats low or high and all 
+ * reads through SPI interface return 0x0000 or 0xFFFF.
+ */
+void FTCalibration::checkVhalf(uint16_t vhalf, FTSampleErrors &errors)
+{
+  int diff = int(vhalf) - VHALF_IDEAL;
+  bool out_of_range = unsigned(diff + VHALF_RANGE) > unsigned(2*VHALF_RANGE);
+  bool stuck = (vhalf == 0x0000) | (vhalf == 0xFFFF);
+  errors.disconnected_ |= (out_of_range & stuck);
+  errors.vhalf_error_ |= (out_of_range & !stuck);
+}
+
+
+void FTCalibration::convertScalar(const FTDataSample *samples, unsigned num_samples, 
+                                  double (*wrenches)[NUM_CHANNELS], FTSampleErrors &errors) const
+{
+  unsigned overload_flags = 0;
+  for (unsigned s=0; s<num_samples; ++s)
+  {
+    const FTDataSample &sample(samples[s]);
+    double in[NUM_CHANNELS];
+    for (unsigned j=0; j<NUM_CHANNELS; ++j)
+    {
+      int raw_data = sample.data_[j];
+      overload_flags |= unsigned((raw_data > overload_limit_) | (raw_data < -overload_limit_)) << j;
+      in[j] = raw_data;
+    }
+    double *out = wrenches[s];
+    for (unsigned i=0; i<NUM_CHANNELS; ++i)
+    {
+      double sum = bias_[i];
+      for (unsigned j=0; j<NUM_CHANNELS; ++j)
+      {
+        sum += columns_[j][i] * in[j];
+      }
+      out[i] = sum;
+    }
+    checkVhalf(sample.vhalf_, errors);
+  }
+  errors.overload_flags_ |= overload_flags;
+}
+
+
+#ifdef __SSE2__
+void FTCalibration::convert(const FTDataSample *samples, unsigned num_samples, 
+                            double (*wrenches)[NUM_CHANNELS], FTSampleErrors &errors) const
+{
+  // The 6 raw channels plus vhalf and counters fill exactly one 128bit register
+  BOOST_STATIC_ASSERT(sizeof(FTDataSample) == sizeof(__m128i));
+
+  const __m128i limit_hi = _mm_set1_epi16(overload_limit_);
+  const __m128i limit_lo = _mm_set1_epi16(-overload_limit_);
+  __m128i overload = _mm_setzero_si128();
+
+  for (unsigned s=0; s<num_samples; ++s)
+  {
+    __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&samples[s]));
+
+    // abs(raw) > limit for all lanes, lanes 6 and 7 (vhalf, counters) are discarded below
+    overload = _mm_or_si128(overload, _mm_or_si128(_mm_cmpgt_epi16(raw, limit_hi), 
+                                                   _mm_cmpgt_epi16(limit_lo, raw)));
+
+    // Sign extend 16bit inputs to 32bit, then convert to double
+    __m128i lo32 = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+    __m128i hi32 = _mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16);
+    __m128d in01 = _mm_cvtepi32_pd(lo32);
+    __m128d in23 = _mm_cvtepi32_pd(_mm_shuffle_epi32(lo32, _MM_SHUFFLE(3,2,3,2)));
+    __m128d in45 = _mm_cvtepi32_pd(hi32);
+
+    __m128d in[NUM_CHANNELS];
+    in[0] = _mm_unpacklo_pd(in01, in01);
+    in[1] = _mm_unpackhi_pd(in01, in01);
+    in[2] = _mm_unpacklo_pd(in23, in23);
+    in[3] = _mm_unpackhi_pd(in23, in23);
+    in[4] = _mm_unpacklo_pd(in45, in45);
+    in[5] = _mm_unpackhi_pd(in45, in45);
+
+    __m128d out0 = _mm_loadu_pd(&bias_[0]);
+    __m128d out1 = _mm_loadu_pd(&bias_[2]);
+    __m128d out2 = _mm_loadu_pd(&bias_[4]);
+    for (unsigned j=0; j<NUM_CHANNELS; ++j)
+    {
+      const double *col = columns_[j];
+      out0 = _mm_add_pd(out0, _mm_mul_pd(_mm_loadu_pd(&col[0]), in[j]));
+      out1 = _mm_add_pd(out1, _mm_mul_pd(_mm_loadu_pd(&col[2]), in[j]));
+      out2 = _mm_add_pd(out2, _mm_mul_pd(_mm_loadu_pd(&col[4]), in[j]));
+    }
+    _mm_storeu_pd(&wrenches[s][0], out0);
+    _mm_storeu_pd(&wrenches[s][2], out1);
+    _mm_storeu_pd(&wrenches[s][4], out2);
+
+    checkVhalf(samples[s].vhalf_, errors);
+  }
+
+  // Narrow 16bit compare masks to 8bits, then collect one bit per channel
+  unsigned mask = _mm_movemask_epi8(_mm_packs_epi16(overload, _mm_setzero_si128()));
+  errors.overload_flags_ |= (mask & ((1<<NUM_CHANNELS)-1));
+}
+#else
+void FTCalibration::convert(const FTDataSample *samples, unsigned num_samples, 
+                            double (*wrenches)[NUM_CHANNELS], FTSampleErrors &errors) const
+{
+  convertScalar(samples, num_samples, wrenches, errors);
+}
+#endif
+
+}; // end namespace ethercat_hardware
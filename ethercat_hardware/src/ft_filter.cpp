@@ -0,0 +1,226 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/ft_filter.h"
+
+#include <math.h>
+
+namespace ethercat_hardware
+{
+
+FTFilter::FTFilter() :
+  num_biquads_(0),
+  primed_(false),
+  decimation_(1),
+  decimation_count_(0),
+  tare_samples_(100),
+  tare_count_(0),
+  taring_(false)
+{
+  for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+  {
+    bias_[ch] = 0.0;
+  }
+  reset();
+}
+
+
+FTFilter::Biquad FTFilter::lowpass(double cutoff, double q, double sample_rate)
+{
+  double w0 = 2.0 * M_PI * cutoff / sample_rate;
+  double alpha = sin(w0) / (2.0 * q);
+  double cos_w0 = cos(w0);
+  double a0 = 1.0 + alpha;
+
+  Biquad biquad;
+  biquad.b0_ = (1.0 - cos_w0) / 2.0 / a0;
+  biquad.b1_ = (1.0 - cos_w0) / a0;
+  biquad.b2_ = (1.0 - cos_w0) / 2.0 / a0;
+  biquad.a1_ = -2.0 * cos_w0 / a0;
+  biquad.a2_ = (1.0 - alpha) / a0;
+  return biquad;
+}
+
+
+bool FTFilter::addBiquad(const Biquad &biquad)
+{
+  if (num_biquads_ >= MAX_BIQUADS)
+  {
+    return false;
+  }
+  biquads_[num_biquads_++] = biquad;
+  primed_ = false;
+  return true;
+}
+
+
+void FTFilter::clearBiquads()
+{
+  num_biquads_ = 0;
+  primed_ = false;
+}
+
+
+void FTFilter::setDecimation(unsigned decimation)
+{
+  decimation_ = (decimation < 1) ? 1 : decimation;
+  reset();
+}
+
+
+void FTFilter::setTareSamples(unsigned tare_samples)
+{
+  tare_samples_ = (tare_samples < 1) ? 1 : tare_samples;
+}
+
+
+void FTFilter::tare()
+{
+  taring_ = true;
+  tare_count_ = 0;
+  for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+  {
+    tare_sum_[ch] = 0.0;
+  }
+}
+
+
+void FTFilter::reset()
+{
+  primed_ = false;
+  decimation_count_ = 0;
+  for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+  {
+    decimation_sum_[ch] = 0.0;
+  }
+}
+
+
+/*!
+ * \brief Set biquad state as if input had been constant forever.
+ *
+ * Avoids a large step transient from zero when filter starts.
+ */
+void FTFilter::prime(const double in[NUM_CHANNELS])
+{
+  double x[NUM_CHANNELS];
+  for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+  {
+    x[ch] = in[ch];
+  }
+
+  for (unsigned i=0; i<num_biquads_; ++i)
+  {
+    const Biquad &bq(biquads_[i]);
+    double dc_gain = (bq.b0_ + bq.b1_ + bq.b2_) / (1.0 + bq.a1_ + bq.a2_);
+    for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+    {
+      double y = dc_gain * x[ch];
+      z1_[i][ch] = y - bq.b0_ * x[ch];
+      z2_[i][ch] = bq.b2_ * x[ch] - bq.a2_ * y;
+      x[ch] = y;
+    }
+  }
+  primed_ = true;
+}
+
+
+bool FTFilter::filter(const double in[NUM_CHANNELS], double out[NUM_CHANNELS])
+{
+  if (!primed_)
+  {
+    prime(in);
+  }
+
+  double x[NUM_CHANNELS];
+  for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+  {
+    x[ch] = in[ch];
+  }
+
+  for (unsigned i=0; i<num_biquads_; ++i)
+  {
+    const Biquad &bq(biquads_[i]);
+    double *z1 = z1_[i];
+    double *z2 = z2_[i];
+    for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+    {
+      double y = bq.b0_ * x[ch] + z1[ch];
+      z1[ch] = bq.b1_ * x[ch] - bq.a1_ * y + z2[ch];
+      z2[ch] = bq.b2_ * x[ch] - bq.a2_ * y;
+      x[ch] = y;
+    }
+  }
+
+  for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+  {
+    decimation_sum_[ch] += x[ch];
+  }
+  if (++decimation_count_ < decimation_)
+  {
+    return false;
+  }
+
+  double scale = 1.0 / decimation_count_;
+  for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+  {
+    x[ch] = decimation_sum_[ch] * scale;
+    decimation_sum_[ch] = 0.0;
+  }
+  decimation_count_ = 0;
+
+  if (taring_)
+  {
+    for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+    {
+      tare_sum_[ch] += x[ch];
+    }
+    if (++tare_count_ >= tare_samples_)
+    {
+      for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+      {
+        bias_[ch] = tare_sum_[ch] / tare_count_;
+      }
+      taring_ = false;
+    }
+  }
+
+  for (unsigned ch=0; ch<NUM_CHANNELS; ++ch)
+  {
+    out[ch] = x[ch] - bias_[ch];
+  }
+  return true;
+}
+
+}; // end namespace ethercat_hardware
@@ -259,7 +259,7 @@ bool MotorHeatingModel::startTemperaturePublisher()
   if (!actuator_name_.empty())
   {
     topic = topic + "/" + actuator_name_;
-    publisher_ = new realtime_tools::RealtimePublisher<ethercat_hardware::MotorTemperature>(ros::NodeHandle(), topic, 1, true);
+    publisher_ = new ethercat_hardware::ExecutorPublisher<ethercat_hardware::MotorTemperature>(ros::NodeHandle(), topic, 1, true);
     if (publisher_ == NULL)
     {
       ROS_ERROR("Could not allocate realtime publisher");
@@ -3,22 +3,37 @@
 //static double max(double a, double b) {return (a>b)?a:b;}
 static double min(double a, double b) {return (a<b)?a:b;}
 
-MotorModel::MotorModel(unsigned trace_size) : 
+// Filter coefficients were chosen for realtime loop running at 1kHz
+static const double NOMINAL_CYCLE_PERIOD = 0.001;
+
+/** \brief Converts coefficient of first-order filter chosen for 1kHz loop to given cycle period
+ *
+ * Result keeps filter time constant the same, regardless of how often filter is sampled.
+ */
+double MotorModel::scaleFilterCoefficient(double coefficient, double cycle_period)
+{
+  return 1.0 - pow(1.0 - coefficient, cycle_period / NOMINAL_CYCLE_PERIOD);
+}
+
+MotorModel::MotorModel(unsigned trace_size, double cycle_period) : 
   trace_size_(trace_size), 
+  cycle_period_(cycle_period),
+  max_publish_delay_((trace_size * 9) / 10),
   trace_index_(0),
   published_traces_(0),
   backemf_constant_(0.0),
-  motor_voltage_error_(0.2),
-  abs_motor_voltage_error_(0.02),
-  measured_voltage_error_(0.2),
-  abs_measured_voltage_error_(0.02),
-  current_error_(0.2),
-  abs_current_error_(0.02),
-  abs_velocity_(0.02),
-  abs_measured_current_(0.02),
-  abs_board_voltage_(0.02),
-  abs_position_delta_(0.02)
+  motor_voltage_error_(scaleFilterCoefficient(0.2, cycle_period)),
+  abs_motor_voltage_error_(scaleFilterCoefficient(0.02, cycle_period)),
+  measured_voltage_error_(scaleFilterCoefficient(0.2, cycle_period)),
+  abs_measured_voltage_error_(scaleFilterCoefficient(0.02, cycle_period)),
+  current_error_(scaleFilterCoefficient(0.2, cycle_period)),
+  abs_current_error_(scaleFilterCoefficient(0.02, cycle_period)),
+  abs_velocity_(scaleFilterCoefficient(0.02, cycle_period)),
+  abs_measured_current_(scaleFilterCoefficient(0.02, cycle_period)),
+  abs_board_voltage_(scaleFilterCoefficient(0.02, cycle_period)),
+  abs_position_delta_(scaleFilterCoefficient(0.02, cycle_period))
 {
+  assert(cycle_period_ > 0.0);
   assert(trace_size_ > 0);
   trace_buffer_.reserve(trace_size_);
   reset();
@@ -56,7 +71,7 @@ bool MotorModel::initialize(const ethercat_hardware::ActuatorInfo &actuator_info
   std::string topic("motor_trace");
   if (!actuator_info.name.empty())
     topic = topic + "/" + actuator_info.name;
-  publisher_ = new realtime_tools::RealtimePublisher<ethercat_hardware::MotorTrace>(ros::NodeHandle(), topic, 1, true);
+  publisher_ = new ethercat_hardware::ExecutorPublisher<ethercat_hardware::MotorTrace>(ros::NodeHandle(), topic, 1, true);
   if (publisher_ == NULL) 
     return false;
 
@@ -126,8 +141,8 @@ void MotorModel::flagPublish(const std::string &reason, int level, int delay)
 {
   if (delay < 0) 
     delay = 0;
-  else if (delay > 900) {
-    delay = 900;
+  else if (delay > max_publish_delay_) {
+    delay = max_publish_delay_;
   }
   if (level > publish_level_)
   {
@@ -257,11 +272,11 @@ void MotorModel::sample(const ethercat_hardware::MotorTraceSample &s)
     // However, delay publishing in case error grows even larger in next few cycles
     if (new_max_voltage_error && (abs_motor_voltage_error_.filter_max() > 0.5))
     {
-      flagPublish("New max voltage error", 1, 500);
+      flagPublish("New max voltage error", 1, cycles(0.5));
     }
     else if( new_max_current_error && (abs_current_error_.filter_max() > (current_error_limit_ * 0.5)))
     {
-      flagPublish("New max current error", 1, 500);
+      flagPublish("New max current error", 1, cycles(0.5));
     }
 
     // Keep track of some values, so that the cause of motor voltage error can be determined laterx
@@ -274,7 +289,7 @@ void MotorModel::sample(const ethercat_hardware::MotorTraceSample &s)
     }
 
     // Update filtered resistance estimate with resistance calculated this cycle
-    motor_resistance_.sample(est_motor_resistance, 0.005 * est_motor_resistance_accuracy);
+    motor_resistance_.sample(est_motor_resistance, scaleFilterCoefficient(0.005 * est_motor_resistance_accuracy, cycle_period_));
 
     diagnostics_mutex_.unlock();
   }
@@ -390,7 +405,7 @@ bool MotorModel::verify()
   if (level > diagnostics_level_) 
   {
     if (level == ERROR)      
-      flagPublish(reason, level, 100);
+      flagPublish(reason, level, cycles(0.1));
     diagnostics_mutex_.lock();
     diagnostics_level_ = level;
     diagnostics_reason_ = reason;
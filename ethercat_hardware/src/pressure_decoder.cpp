@@ -0,0 +1,95 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/pressure_decoder.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ethercat_hardware
+{
+
+PressureDecoder::PressureDecoder() :
+  has_calibration_(false)
+{
+  for (unsigned i=0; i<TOTAL_CELLS; ++i)
+  {
+    raw_[i] = 0;
+    calibrated_[i] = 0.0;
+    offsets_[i] = 0.0;
+    gains_[i] = 1.0;
+  }
+}
+
+
+void PressureDecoder::setCalibration(unsigned sensor, const double *offsets, const double *gains)
+{
+  for (unsigned i=0; i<NUM_CELLS; ++i)
+  {
+    offsets_[sensor*NUM_CELLS + i] = offsets[i];
+    gains_[sensor*NUM_CELLS + i] = gains[i];
+  }
+  has_calibration_ = true;
+}
+
+
+void PressureDecoder::decode(const void *cells)
+{
+  const unsigned char *bytes = static_cast<const unsigned char *>(cells);
+  unsigned i=0;
+#ifdef __SSE2__
+  // Swap bytes of 8 cells at a time, stop before reading past end of input
+  for (; i+8 <= TOTAL_CELLS; i+=8)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 2*i));
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    _mm_store_si128(reinterpret_cast<__m128i*>(raw_ + i), v);
+  }
+#endif
+  for (; i<TOTAL_CELLS; ++i)
+  {
+    raw_[i] = (uint16_t(bytes[2*i]) << 8) | uint16_t(bytes[2*i+1]);
+  }
+
+  if (has_calibration_)
+  {
+    for (i=0; i<TOTAL_CELLS; ++i)
+    {
+      calibrated_[i] = (double(raw_[i]) - offsets_[i]) * gains_[i];
+    }
+  }
+}
+
+}; // end namespace ethercat_hardware
@@ -0,0 +1,90 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/process_data_snapshot.h"
+
+namespace ethercat_hardware
+{
+
+ProcessDataSnapshot::ProcessDataSnapshot() : 
+  sequence_(0), buffer_(NULL), size_(0), updating_(false)
+{
+}
+
+
+void ProcessDataSnapshot::setLayout(const std::vector<unsigned> &offsets)
+{
+  offsets_ = offsets;
+}
+
+
+void ProcessDataSnapshot::beginUpdate()
+{
+  if (!updating_)
+  {
+    updating_ = true;
+    sequence_.store(sequence_.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed);
+    boost::atomic_thread_fence(boost::memory_order_release);
+  }
+}
+
+
+void ProcessDataSnapshot::publish(const unsigned char *buffer, unsigned size)
+{
+  // Make sequence odd while pointer changes, unless beginUpdate() already did
+  beginUpdate();
+  buffer_.store(buffer, boost::memory_order_relaxed);
+  size_.store(size, boost::memory_order_relaxed);
+  sequence_.store(sequence_.load(boost::memory_order_relaxed) + 1, boost::memory_order_release);
+  updating_ = false;
+}
+
+
+bool ProcessDataSnapshot::begin(View &view) const
+{
+  view.sequence_ = sequence_.load(boost::memory_order_acquire);
+  view.version_ = view.sequence_ / 2;
+  view.data_ = buffer_.load(boost::memory_order_relaxed);
+  view.size_ = size_.load(boost::memory_order_relaxed);
+  return ((view.sequence_ & 1) == 0) && (view.data_ != NULL);
+}
+
+
+bool ProcessDataSnapshot::validate(const View &view) const
+{
+  boost::atomic_thread_fence(boost::memory_order_acquire);
+  return ((view.sequence_ & 1) == 0) && (sequence_.load(boost::memory_order_relaxed) == view.sequence_);
+}
+
+}
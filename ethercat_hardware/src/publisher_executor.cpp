@@ -0,0 +1,300 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/publisher_executor.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace ethercat_hardware
+{
+
+PublisherSlot::PublisherSlot(PublisherExecutor &executor) :
+  state_(IDLE),
+  executor_(executor)
+{
+}
+
+PublisherSlot::~PublisherSlot()
+{
+}
+
+bool PublisherSlot::trylock()
+{
+  int expected = IDLE;
+  return state_.compare_exchange_strong(expected, int(WRITING));
+}
+
+void PublisherSlot::lock()
+{
+  while (!trylock())
+  {
+    usleep(200);
+  }
+}
+
+void PublisherSlot::unlock()
+{
+  state_.store(IDLE);
+}
+
+void PublisherSlot::unlockAndPublish()
+{
+  state_.store(READY);
+  if (!executor_.schedule(this))
+  {
+    // Message is lost, but slot should still be usable next cycle
+    state_.store(IDLE);
+  }
+}
+
+void PublisherSlot::stop()
+{
+  int state = state_.load();
+  while ((state == READY) || (state == PUBLISHING))
+  {
+    usleep(200);
+    state = state_.load();
+  }
+}
+
+void PublisherSlot::run()
+{
+  state_.store(PUBLISHING);
+  publish();
+  state_.store(IDLE);
+}
+
+
+PublisherExecutor &PublisherExecutor::instance()
+{
+  static PublisherExecutor executor(DEFAULT_THREADS);
+  return executor;
+}
+
+PublisherExecutor::PublisherExecutor(unsigned num_threads) :
+  num_threads_(num_threads),
+  ready_(MAX_PENDING),
+  shutdown_(false),
+  dropped_count_(0),
+  next_periodic_id_(1)
+{
+  if (sem_init(&semaphore_, 0, 0) != 0)
+  {
+    int error = errno;
+    ROS_FATAL("Initializing publisher executor semaphore failed : %s", strerror(error));
+    sleep(1); // wait for ros to flush rosconsole output
+    exit(EXIT_FAILURE);
+  }
+
+  // Periodic tasks are added from non-realtime code, so reserving space is not critical
+  periodic_.reserve(16);
+
+  for (unsigned i=0; i<num_threads_; ++i)
+  {
+    threads_.create_thread(boost::bind(&PublisherExecutor::threadFunc, this));
+  }
+}
+
+PublisherExecutor::~PublisherExecutor()
+{
+  shutdown_.store(true);
+  for (unsigned i=0; i<num_threads_; ++i)
+  {
+    sem_post(&semaphore_);
+  }
+  threads_.join_all();
+  sem_destroy(&semaphore_);
+}
+
+bool PublisherExecutor::schedule(PublisherSlot *slot)
+{
+  // bounded_push() only uses preallocated nodes, so it does not allocate memory
+  if (!ready_.bounded_push(slot))
+  {
+    ++dropped_count_;
+    return false;
+  }
+  sem_post(&semaphore_);
+  return true;
+}
+
+unsigned PublisherExecutor::addPeriodic(const boost::function<void()> &task, double period)
+{
+  boost::mutex::scoped_lock lock(periodic_mutex_);
+  PeriodicTask periodic;
+  periodic.id_ = next_periodic_id_++;
+  periodic.task_ = task;
+  periodic.period_ = period;
+  periodic.next_time_ = now() + period;
+  periodic.running_ = false;
+  periodic_.push_back(periodic);
+  lock.unlock();
+
+  // Wake a thread so it waits with new deadline
+  sem_post(&semaphore_);
+  return periodic.id_;
+}
+
+void PublisherExecutor::removePeriodic(unsigned id)
+{
+  boost::mutex::scoped_lock lock(periodic_mutex_);
+  while (true)
+  {
+    std::vector<PeriodicTask>::iterator it = periodic_.begin();
+    while ((it != periodic_.end()) && (it->id_ != id))
+      ++it;
+    if (it == periodic_.end())
+      return;
+    if (!it->running_)
+    {
+      periodic_.erase(it);
+      return;
+    }
+    // Task is running in other thread, wait for it to finish
+    periodic_cond_.wait(lock);
+  }
+}
+
+double PublisherExecutor::now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+double PublisherExecutor::nextDeadline(double limit)
+{
+  boost::mutex::scoped_lock lock(periodic_mutex_);
+  for (unsigned i=0; i<periodic_.size(); ++i)
+  {
+    if (!periodic_[i].running_)
+    {
+      limit = std::min(limit, periodic_[i].next_time_);
+    }
+  }
+  return limit;
+}
+
+void PublisherExecutor::runPeriodic()
+{
+  boost::mutex::scoped_lock lock(periodic_mutex_);
+  double current = now();
+  for (unsigned i=0; i<periodic_.size(); ++i)
+  {
+    PeriodicTask &periodic(periodic_[i]);
+    if (periodic.running_ || (periodic.next_time_ > current))
+      continue;
+
+    periodic.running_ = true;
+    periodic.next_time_ += periodic.period_;
+    if (periodic.next_time_ < current)
+    {
+      // Fell behind, don't try to catch up 
+      periodic.next_time_ = current + periodic.period_;
+    }
+    unsigned id = periodic.id_;
+    boost::function<void()> task(periodic.task_);
+
+    // Task may take a while, don't hold lock while it runs
+    lock.unlock();
+    task();
+    lock.lock();
+
+    // Vector may have changed while unlocked, so find task again
+    for (i=0; i<periodic_.size(); ++i)
+    {
+      if (periodic_[i].id_ == id)
+      {
+        periodic_[i].running_ = false;
+        break;
+      }
+    }
+    periodic_cond_.notify_all();
+    // Start over, in case other tasks became due
+    i = unsigned(-1);
+    current = now();
+  }
+}
+
+void PublisherExecutor::threadFunc()
+{
+  // Wake up at least this often, even if nothing is scheduled
+  static const double MAX_WAIT = 0.1;
+
+  while (!shutdown_.load())
+  {
+    double wait = nextDeadline(now() + MAX_WAIT) - now();
+    if (wait > 0.0)
+    {
+      // sem_timedwait uses absolute realtime clock
+      timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      double sec = floor(wait);
+      deadline.tv_sec += time_t(sec);
+      deadline.tv_nsec += long((wait - sec) * 1e9);
+      if (deadline.tv_nsec >= 1000000000L)
+      {
+        deadline.tv_nsec -= 1000000000L;
+        ++deadline.tv_sec;
+      }
+      sem_timedwait(&semaphore_, &deadline);
+    }
+
+    PublisherSlot *slot;
+    while (ready_.pop(slot))
+    {
+      slot->run();
+    }
+
+    runPeriodic();
+  }
+
+  // Publish anything left before exiting
+  PublisherSlot *slot;
+  while (ready_.pop(slot))
+  {
+    slot->run();
+  }
+}
+
+}; // end namespace ethercat_hardware
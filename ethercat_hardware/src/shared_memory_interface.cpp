@@ -0,0 +1,389 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the Willow Garage nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ethercat_hardware/shared_memory_interface.h"
+
+#include <ros/ros.h>
+#include <boost/foreach.hpp>
+#include <string.h>
+#include <new>
+
+namespace ethercat_hardware
+{
+
+using namespace boost::interprocess;
+
+static size_t segmentSize(unsigned num_actuators)
+{
+  return sizeof(SharedMemoryHeader) + 
+    num_actuators * (sizeof(SharedActuatorState) + sizeof(SharedActuatorCommand) + SHARED_ACTUATOR_NAME_SIZE);
+}
+
+
+/*!
+ * \brief Finds arrays that follow header in shared memory segment
+ */
+static void segmentLayout(void *base, unsigned num_actuators, SharedMemoryHeader *&header, 
+                          SharedActuatorState *&states, SharedActuatorCommand *&commands, char *&names)
+{
+  header = (SharedMemoryHeader *)base;
+  states = (SharedActuatorState *)(header + 1);
+  commands = (SharedActuatorCommand *)(states + num_actuators);
+  names = (char *)(commands + num_actuators);
+}
+
+
+SharedMemoryMirror::SharedMemoryMirror() : 
+  header_(NULL), states_(NULL), commands_(NULL), 
+  last_command_cycle_(0), have_commands_(false), cycle_(0), timeout_cycles_(0), torn_reads_(0)
+{
+}
+
+
+SharedMemoryMirror::~SharedMemoryMirror()
+{
+  region_.reset();
+  shm_.reset();
+  if (!name_.empty())
+  {
+    shared_memory_object::remove(name_.c_str());
+  }
+}
+
+
+bool SharedMemoryMirror::initialize(const std::string &name, pr2_hardware_interface::HardwareInterface *hw, 
+                                    double cycle_period, double command_timeout)
+{
+  actuators_.clear();
+  for (pr2_hardware_interface::ActuatorMap::const_iterator it = hw->actuators_.begin(); it != hw->actuators_.end(); ++it)
+  {
+    actuators_.push_back(it->second);
+  }
+  unsigned num_actuators = actuators_.size();
+
+  try
+  {
+    shared_memory_object::remove(name.c_str());
+    shm_.reset(new shared_memory_object(create_only, name.c_str(), read_write));
+    name_ = name;
+    shm_->truncate(segmentSize(num_actuators));
+    region_.reset(new mapped_region(*shm_, read_write));
+  }
+  catch (interprocess_exception &e)
+  {
+    ROS_ERROR("Could not create shared memory '%s' : %s", name.c_str(), e.what());
+    return false;
+  }
+
+  char *names;
+  segmentLayout(region_->get_address(), num_actuators, header_, states_, commands_, names);
+  memset(region_->get_address(), 0, region_->get_size());
+  new (header_) SharedMemoryHeader();
+  header_->num_actuators_ = num_actuators;
+  header_->cycle_period_ns_ = uint32_t(cycle_period * 1e9 + 0.5);
+  header_->state_sequence_.store(0);
+  header_->latency_cycles_.store(0);
+  header_->max_latency_cycles_.store(0);
+  header_->stale_cycles_.store(0);
+  header_->command_sequence_.store(0);
+  for (unsigned i = 0; i < num_actuators; ++i)
+  {
+    strncpy(names + i * SHARED_ACTUATOR_NAME_SIZE, actuators_[i]->name_.c_str(), SHARED_ACTUATOR_NAME_SIZE - 1);
+  }
+
+  if (!header_->state_sequence_.is_lock_free() || !header_->command_sequence_.is_lock_free())
+  {
+    ROS_WARN("Shared memory sequence counters are not lock-free on this platform");
+  }
+
+  last_commands_.assign(num_actuators, SharedActuatorCommand());
+  read_commands_.assign(num_actuators, SharedActuatorCommand());
+  timeout_cycles_ = unsigned(command_timeout / cycle_period + 0.5);
+  
+  // Publish magic last, so clients do not attach to a partially initialized segment
+  header_->version_ = SharedMemoryHeader::VERSION;
+  boost::atomic_thread_fence(boost::memory_order_release);
+  header_->magic_ = SharedMemoryHeader::MAGIC;
+
+  ROS_INFO("Shared memory interface '%s' : %u actuators, command timeout %u cycles", 
+           name.c_str(), num_actuators, timeout_cycles_);
+  return true;
+}
+
+
+void SharedMemoryMirror::readCommands()
+{
+  if (header_ == NULL)
+  {
+    return;
+  }
+
+  unsigned num_actuators = actuators_.size();
+  if (num_actuators == 0)
+  {
+    return;
+  }
+  uint64_t sequence = header_->command_sequence_.load(boost::memory_order_acquire);
+  if (sequence & 1)
+  {
+    // Controller is writing, use previous commands
+    ++torn_reads_;
+  }
+  else if (sequence != 0)
+  {
+    uint64_t command_cycle = header_->command_cycle_;
+    memcpy(&read_commands_[0], commands_, num_actuators * sizeof(SharedActuatorCommand));
+    boost::atomic_thread_fence(boost::memory_order_acquire);
+    if (header_->command_sequence_.load(boost::memory_order_relaxed) == sequence)
+    {
+      last_commands_.swap(read_commands_);
+      last_command_cycle_ = command_cycle;
+      have_commands_ = true;
+    }
+    else
+    {
+      ++torn_reads_;
+    }
+  }
+
+  // Until a controller process writes commands, all actuators stay with in-process controllers
+  if (!have_commands_)
+  {
+    return;
+  }
+
+  uint64_t latency = (cycle_ > last_command_cycle_) ? cycle_ - last_command_cycle_ : 0;
+  bool stale = (latency > timeout_cycles_);
+  header_->latency_cycles_.store(latency, boost::memory_order_relaxed);
+  if (latency > header_->max_latency_cycles_.load(boost::memory_order_relaxed))
+  {
+    header_->max_latency_cycles_.store(latency, boost::memory_order_relaxed);
+  }
+
+  unsigned num_claimed = 0;
+  for (unsigned i = 0; i < num_actuators; ++i)
+  {
+    const SharedActuatorCommand &command(last_commands_[i]);
+    if (!command.claimed_)
+    {
+      continue;
+    }
+    ++num_claimed;
+    pr2_hardware_interface::Actuator *actuator = actuators_[i];
+    actuator->command_.enable_ = !stale && command.enable_;
+    actuator->command_.effort_ = stale ? 0.0 : command.effort_;
+    if (!stale && command.set_zero_offset_)
+    {
+      actuator->state_.zero_offset_ = command.zero_offset_;
+    }
+  }
+
+  if (stale && (num_claimed > 0))
+  {
+    header_->stale_cycles_.fetch_add(1, boost::memory_order_relaxed);
+  }
+}
+
+
+void SharedMemoryMirror::writeState()
+{
+  if (header_ == NULL)
+  {
+    return;
+  }
+
+  uint64_t sequence = header_->state_sequence_.load(boost::memory_order_relaxed);
+  header_->state_sequence_.store(sequence + 1, boost::memory_order_relaxed);
+  boost::atomic_thread_fence(boost::memory_order_release);
+
+  for (unsigned i = 0; i < actuators_.size(); ++i)
+  {
+    const pr2_hardware_interface::ActuatorState &state(actuators_[i]->state_);
+    SharedActuatorState &s(states_[i]);
+    s.timestamp_ = state.timestamp_;
+    s.sample_timestamp_sec_ = state.sample_timestamp_.sec;
+    s.sample_timestamp_nsec_ = state.sample_timestamp_.nsec;
+    s.position_ = state.position_;
+    s.velocity_ = state.velocity_;
+    s.last_measured_effort_ = state.last_measured_effort_;
+    s.last_commanded_effort_ = state.last_commanded_effort_;
+    s.max_effort_ = state.max_effort_;
+    s.last_calibration_rising_edge_ = state.last_calibration_rising_edge_;
+    s.last_calibration_falling_edge_ = state.last_calibration_falling_edge_;
+    s.zero_offset_ = state.zero_offset_;
+    s.encoder_count_ = state.encoder_count_;
+    s.is_enabled_ = state.is_enabled_;
+    s.halted_ = state.halted_;
+    s.calibration_reading_ = state.calibration_reading_;
+    s.calibration_rising_edge_valid_ = state.calibration_rising_edge_valid_;
+    s.calibration_falling_edge_valid_ = state.calibration_falling_edge_valid_;
+  }
+  header_->state_cycle_ = ++cycle_;
+
+  header_->state_sequence_.store(sequence + 2, boost::memory_order_release);
+}
+
+
+unsigned SharedMemoryMirror::latencyCycles() const
+{
+  return header_ ? header_->latency_cycles_.load(boost::memory_order_relaxed) : 0;
+}
+
+
+unsigned SharedMemoryMirror::maxLatencyCycles() const
+{
+  return header_ ? header_->max_latency_cycles_.load(boost::memory_order_relaxed) : 0;
+}
+
+
+uint64_t SharedMemoryMirror::staleCycles() const
+{
+  return header_ ? header_->stale_cycles_.load(boost::memory_order_relaxed) : 0;
+}
+
+
+SharedMemoryClient::SharedMemoryClient() : 
+  header_(NULL), states_(NULL), commands_(NULL), names_(NULL)
+{
+}
+
+
+bool SharedMemoryClient::attach(const std::string &name)
+{
+  header_ = NULL;
+  try
+  {
+    shm_.reset(new shared_memory_object(open_only, name.c_str(), read_write));
+    region_.reset(new mapped_region(*shm_, read_write));
+  }
+  catch (interprocess_exception &e)
+  {
+    ROS_ERROR("Could not open shared memory '%s' : %s", name.c_str(), e.what());
+    return false;
+  }
+
+  SharedMemoryHeader *header = (SharedMemoryHeader *) region_->get_address();
+  if ((region_->get_size() < sizeof(SharedMemoryHeader)) || (header->magic_ != SharedMemoryHeader::MAGIC))
+  {
+    ROS_ERROR("Shared memory '%s' is not initialized by EtherCAT driver", name.c_str());
+    return false;
+  }
+  boost::atomic_thread_fence(boost::memory_order_acquire);
+  if (header->version_ != SharedMemoryHeader::VERSION)
+  {
+    ROS_ERROR("Shared memory '%s' has version %u, expected %u", name.c_str(), header->version_, SharedMemoryHeader::VERSION);
+    return false;
+  }
+  if (region_->get_size() < segmentSize(header->num_actuators_))
+  {
+    ROS_ERROR("Shared memory '%s' is too small for %u actuators", name.c_str(), header->num_actuators_);
+    return false;
+  }
+
+  char *names;
+  segmentLayout(region_->get_address(), header->num_actuators_, header_, states_, commands_, names);
+  names_ = names;
+  return true;
+}
+
+
+std::string SharedMemoryClient::actuatorName(unsigned index) const
+{
+  if (index >= numActuators())
+  {
+    return "";
+  }
+  return std::string(names_ + index * SHARED_ACTUATOR_NAME_SIZE);
+}
+
+
+int SharedMemoryClient::actuatorIndex(const std::string &name) const
+{
+  for (unsigned i = 0; i < numActuators(); ++i)
+  {
+    if (actuatorName(i) == name)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+bool SharedMemoryClient::readState(std::vector<SharedActuatorState> &states, uint64_t &cycle) const
+{
+  if (header_ == NULL)
+  {
+    return false;
+  }
+  uint64_t sequence = header_->state_sequence_.load(boost::memory_order_acquire);
+  if (sequence & 1)
+  {
+    return false;
+  }
+  states.resize(header_->num_actuators_);
+  memcpy(&states[0], states_, states.size() * sizeof(SharedActuatorState));
+  cycle = header_->state_cycle_;
+  boost::atomic_thread_fence(boost::memory_order_acquire);
+  return header_->state_sequence_.load(boost::memory_order_relaxed) == sequence;
+}
+
+
+void SharedMemoryClient::writeCommands(const std::vector<SharedActuatorCommand> &commands, uint64_t state_cycle)
+{
+  if ((header_ == NULL) || (commands.size() != header_->num_actuators_))
+  {
+    return;
+  }
+  uint64_t sequence = header_->command_sequence_.load(boost::memory_order_relaxed);
+  header_->command_sequence_.store(sequence + 1, boost::memory_order_relaxed);
+  boost::atomic_thread_fence(boost::memory_order_release);
+  memcpy(commands_, &commands[0], commands.size() * sizeof(SharedActuatorCommand));
+  header_->command_cycle_ = state_cycle;
+  header_->command_sequence_.store(sequence + 2, boost::memory_order_release);
+}
+
+
+unsigned SharedMemoryClient::latencyCycles() const
+{
+  return header_ ? header_->latency_cycles_.load(boost::memory_order_relaxed) : 0;
+}
+
+
+unsigned SharedMemoryClient::maxLatencyCycles() const
+{
+  return header_ ? header_->max_latency_cycles_.load(boost::memory_order_relaxed) : 0;
+}
+
+}
@@ -54,6 +54,9 @@ void WG021::construct(EtherCAT_SlaveHandler *sh, int &start_address)
 {
   WG0X::construct(sh, start_address);
 
+  // WG021 has no use for application ram
+  app_ram_status_ = APP_RAM_NOT_APPLICABLE;
+
   unsigned int base_status = sizeof(WG0XStatus);
 
   // As good a place as any for making sure that compiler actually packed these structures correctly
@@ -113,9 +116,6 @@ void WG021::construct(EtherCAT_SlaveHandler *sh, int &start_address)
 
 int WG021::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_unprogrammed)
 {
-  // WG021 has no use for application ram
-  app_ram_status_ = APP_RAM_NOT_APPLICABLE;
-
   int retval = WG0X::initialize(hw, allow_unprogrammed);
 
   // Register digital outs with pr2_hardware_interface::HardwareInterface
@@ -153,6 +153,23 @@ int WG021::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_
     projector_.command_.current_ = 0;
   }
 
+  // Projector does not need to be updated every cycle.  
+  // Allow its process data to be exchanged at a slower rate to save bandwidth.
+  if (use_ros_)
+  {
+    ros::NodeHandle nh(string("~/") + actuator_info_.name_);
+    int exchange_divisor;
+    if (nh.getParam("exchange_divisor", exchange_divisor))
+    {
+      if (exchange_divisor < 1)
+      {
+        ROS_WARN("Invalid exchange divisor (%d) for %s, using 1", exchange_divisor, actuator_info_.name_);
+        exchange_divisor = 1;
+      }
+      exchange_divisor_ = exchange_divisor;
+    }
+  }
+
   return retval;
 }
 
@@ -53,6 +53,12 @@ void WG05::construct(EtherCAT_SlaveHandler *sh, int &start_address)
 {
   WG0X::construct(sh, start_address);
 
+  // Determine if device supports application RAM
+  if ((fw_major_ == 1) && (fw_minor_ >= 21)) 
+  {
+    app_ram_status_ = APP_RAM_PRESENT;
+  }
+
   unsigned int base_status = sizeof(WG0XStatus);
 
   // As good a place as any for making sure that compiler actually packed these structures correctly
@@ -114,16 +120,10 @@ void WG05::construct(EtherCAT_SlaveHandler *sh, int &start_address)
 
 int WG05::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_unprogrammed)
 {
-  if ((fw_major_ == 1) && (fw_minor_ >= 21)) 
-  {
-    app_ram_status_ = APP_RAM_PRESENT;
-  }
-
   int retval = WG0X::initialize(hw, allow_unprogrammed);
 
   EthercatDirectCom com(EtherCAT_DataLinkLayer::instance());
 
-  // Determine if device supports application RAM
   if (!retval)
   {
     if (use_ros_)
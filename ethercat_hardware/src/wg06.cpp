@@ -52,27 +52,41 @@
 
 PLUGINLIB_EXPORT_CLASS(WG06, EthercatDevice);
 
+// Slowest expected FT sample rate is 3kHz
+static const double FT_MIN_SAMPLE_PERIOD = 1.0 / 3000.0;
+
 
 WG06::WG06() :
   has_accel_and_ft_(false),
   pressure_checksum_error_(false),
   pressure_checksum_error_count_(0),
+  pressure_mapped_(true),
   accelerometer_samples_(0), 
   accelerometer_missed_samples_(0),
+  accelerometer_sample_count_(0),
+  accel_stream_(NULL),
+  hw_(NULL),
   first_publish_(true),
   last_pressure_time_(0),
   pressure_publisher_(NULL),
+  enable_pressure_contact_(false),
+  last_pressure_zero_command_(0),
   accel_publisher_(NULL),
   ft_overload_limit_(31100),
   ft_overload_flags_(0),
   ft_disconnected_(false),
   ft_vhalf_error_(false),
   ft_sampling_rate_error_(false),
+  ft_empty_cycles_(0),
+  max_ft_empty_cycles_(0),
   ft_sample_count_(0),
   ft_missed_samples_(0),
   diag_last_ft_sample_count_(0),
   raw_ft_publisher_(NULL),
   ft_publisher_(NULL),
+  ft_stream_(NULL),
+  enable_ft_filter_(false),
+  last_ft_tare_command_(0),
   enable_pressure_sensor_(true),
   enable_ft_sensor_(false),
   enable_soft_processor_access_(true)
@@ -85,12 +99,19 @@ WG06::~WG06()
 {
   if (pressure_publisher_) delete pressure_publisher_;
   if (accel_publisher_) delete accel_publisher_;
+  if (ft_stream_) delete ft_stream_;
+  if (accel_stream_) delete accel_stream_;
 }
 
 void WG06::construct(EtherCAT_SlaveHandler *sh, int &start_address)
 { 
   WG0X::construct(sh, start_address);
 
+  if ( ((fw_major_ == 1) && (fw_minor_ >= 1))  ||  (fw_major_ >= 2) )
+  {
+    app_ram_status_ = APP_RAM_PRESENT;
+  }
+
   has_accel_and_ft_ = false;
 
   // As good a place as any for making sure that compiler actually packed these structures correctly
@@ -132,10 +153,17 @@ void WG06::construct(EtherCAT_SlaveHandler *sh, int &start_address)
   {
     ROS_ERROR("Unsupported WG06 FW major version %d", fw_major_);
   }
-  status_size_ += pressure_size_;
 
+  // Pressure data has its own FMMU and sync manager, so it can be left out of 
+  // cyclic process data when the pressure sensor has been disabled.
+  // F/T data is covered by status checksum, so it cannot be dropped the same way.
+  pressure_mapped_ = pressureRegionNeeded();
+  if (pressure_mapped_)
+  {
+    status_size_ += pressure_size_;
+  }
 
-  EtherCAT_FMMU_Config *fmmu = new EtherCAT_FMMU_Config(3);
+  EtherCAT_FMMU_Config *fmmu = new EtherCAT_FMMU_Config(pressure_mapped_ ? 3 : 2);
   //ROS_DEBUG("device %d, command  0x%X = 0x10000+%d", (int)sh->get_ring_position(), start_address, start_address-0x10000);
   (*fmmu)[0] = EC_FMMU(start_address, // Logical start address
                        command_size_,// Logical length
@@ -162,21 +190,24 @@ void WG06::construct(EtherCAT_SlaveHandler *sh, int &start_address)
 
   start_address += base_status_size;
 
-  (*fmmu)[2] = EC_FMMU(start_address, // Logical start address
-                       pressure_size_, // Logical length
-                       0x00, // Logical StartBit
-                       0x07, // Logical EndBit
-                       pressure_phy_addr, // Physical Start address
-                       0x00, // Physical StartBit
-                       true, // Read Enable
-                       false, // Write Enable
-                       true); // Enable
-
-  start_address += pressure_size_;
+  if (pressure_mapped_)
+  {
+    (*fmmu)[2] = EC_FMMU(start_address, // Logical start address
+                         pressure_size_, // Logical length
+                         0x00, // Logical StartBit
+                         0x07, // Logical EndBit
+                         pressure_phy_addr, // Physical Start address
+                         0x00, // Physical StartBit
+                         true, // Read Enable
+                         false, // Write Enable
+                         true); // Enable
+
+    start_address += pressure_size_;
+  }
 
   sh->set_fmmu_config(fmmu);
 
-  EtherCAT_PD_Config *pd = new EtherCAT_PD_Config(5);
+  EtherCAT_PD_Config *pd = new EtherCAT_PD_Config(pressure_mapped_ ? 5 : 4);
 
   // Sync managers
   (*pd)[0] = EC_SyncMan(COMMAND_PHY_ADDR, command_size_, EC_BUFFERED, EC_WRITTEN_FROM_MASTER);
@@ -193,34 +224,71 @@ void WG06::construct(EtherCAT_SlaveHandler *sh, int &start_address)
   (*pd)[3] = EC_SyncMan(WGMailbox::MBX_STATUS_PHY_ADDR, WGMailbox::MBX_STATUS_SIZE, EC_QUEUED);
   (*pd)[3].ChannelEnable = true;
 
-  (*pd)[4] = EC_SyncMan(pressure_phy_addr, pressure_size_);
-  (*pd)[4].ChannelEnable = true;
+  if (pressure_mapped_)
+  {
+    (*pd)[4] = EC_SyncMan(pressure_phy_addr, pressure_size_);
+    (*pd)[4].ChannelEnable = true;
+  }
 
   sh->set_pd_config(pd);
 }
 
 
-int WG06::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_unprogrammed)
+/*!
+ * \brief Returns true if pressure data region should be part of cyclic process data.
+ *
+ * Only firmware that can disable the pressure sensor (2.xx and later) has its pressure region unmapped.
+ * Before initialize() is run, enable_pressure_sensor_ is true, unless chain cache says it was disabled in previous run.
+ */
+bool WG06::pressureRegionNeeded() const
 {
-  if ( ((fw_major_ == 1) && (fw_minor_ >= 1))  ||  (fw_major_ >= 2) )
-  {
-    app_ram_status_ = APP_RAM_PRESENT;
-  }
+  return enable_pressure_sensor_ || (fw_major_ < 2);
+}
+
+
+/*!
+ * \brief Returns true if enabled sensors no longer match process data layout set up by construct().
+ *
+ * Sensors are enabled by parameters that are read during initialize(), after 
+ * EtherCAT chain has already been put into OP state with the full layout.
+ */
+bool WG06::processDataLayoutChanged() const
+{
+  return pressure_mapped_ != pressureRegionNeeded();
+}
+
+
+static const unsigned LAYOUT_PRESSURE_MAPPED = 0x1;
+
+unsigned WG06::processDataLayout() const
+{
+  return pressure_mapped_ ? LAYOUT_PRESSURE_MAPPED : 0;
+}
+
+
+/*!
+ * \brief Assumes pressure sensor is enabled as it was in previous run.
+ * Real setting is read from parameters by preInitialize().
+ */
+void WG06::expectProcessDataLayout(unsigned layout)
+{
+  enable_pressure_sensor_ = (layout & LAYOUT_PRESSURE_MAPPED) != 0;
+}
+
+
+//! Pressure sensor is enabled by default
+unsigned WG06::defaultProcessDataLayout() const
+{
+  return LAYOUT_PRESSURE_MAPPED;
+}
+
+
+int WG06::preInitialize(bool allow_unprogrammed)
+{
+  int retval = WG0X::preInitialize(allow_unprogrammed);
 
-  int retval = WG0X::initialize(hw, allow_unprogrammed);
-  
   if (!retval && use_ros_)
   {
-    bool poor_measured_motor_voltage = false;
-    double max_pwm_ratio = double(0x2700) / double(PWM_MAX);
-    double board_resistance = 5.0;
-    if (!WG0X::initializeMotorModel(hw, "WG006", max_pwm_ratio, board_resistance, poor_measured_motor_voltage)) 
-    {
-      ROS_FATAL("Initializing motor trace failed");
-      sleep(1); // wait for ros to flush rosconsole output
-      return -1;
-    }
-
     // For some versions of software pressure and force/torque sensors can be
     // selectively enabled / disabled    
     ros::NodeHandle nh(string("~/") + actuator_.name_);
@@ -239,21 +307,68 @@ int WG06::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_u
       enable_ft_sensor_ = false;
     }
 
-    // FW version 2+ supports selectively enabling/disabling pressure and F/T sensor
-    if (fw_major_ >= 2)
+    EthercatDirectCom com(EtherCAT_DataLinkLayer::instance());
+    if (writeSensorEnable(&com) != 0)
     {
-      static const uint8_t PRESSURE_ENABLE_FLAG = 0x1;
-      static const uint8_t FT_ENABLE_FLAG       = 0x2;
-      static const unsigned PRESSURE_FT_ENABLE_ADDR = 0xAA;
-      uint8_t pressure_ft_enable = 0;
-      if (enable_pressure_sensor_) pressure_ft_enable |= PRESSURE_ENABLE_FLAG;
-      if (enable_ft_sensor_) pressure_ft_enable |= FT_ENABLE_FLAG;
-      EthercatDirectCom com(EtherCAT_DataLinkLayer::instance());
-      if (writeMailbox(&com, PRESSURE_FT_ENABLE_ADDR, &pressure_ft_enable, 1) != 0)
-      {
-        ROS_FATAL("Could not enable/disable pressure and force/torque sensors");
-        return -1;
-      }
+      ROS_FATAL("Could not enable/disable pressure and force/torque sensors");
+      return -1;
+    }
+  }
+
+  return retval;
+}
+
+
+/*!
+ * \brief Tells firmware which of pressure and force/torque sensors are enabled.
+ * FW version 2+ supports selectively enabling/disabling pressure and F/T sensor, 
+ * older firmware needs nothing to be written.
+ */
+int WG06::writeSensorEnable(EthercatCom *com)
+{
+  if (fw_major_ < 2)
+  {
+    return 0;
+  }
+
+  static const uint8_t PRESSURE_ENABLE_FLAG = 0x1;
+  static const uint8_t FT_ENABLE_FLAG       = 0x2;
+  static const unsigned PRESSURE_FT_ENABLE_ADDR = 0xAA;
+  uint8_t pressure_ft_enable = 0;
+  if (enable_pressure_sensor_) pressure_ft_enable |= PRESSURE_ENABLE_FLAG;
+  if (enable_ft_sensor_) pressure_ft_enable |= FT_ENABLE_FLAG;
+  return writeMailbox(com, PRESSURE_FT_ENABLE_ADDR, &pressure_ft_enable, 1);
+}
+
+
+/*!
+ * \brief Sensor enable setting is lost when gripper is reset, firmware comes back with defaults.
+ */
+int WG06::reconfigure(EthercatCom *com)
+{
+  if (use_ros_ && (writeSensorEnable(com) != 0))
+  {
+    ROS_ERROR("Could not enable/disable pressure and force/torque sensors of %s after reset", actuator_.name_.c_str());
+    return -1;
+  }
+  return 0;
+}
+
+
+int WG06::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_unprogrammed)
+{
+  int retval = WG0X::initialize(hw, allow_unprogrammed);
+  
+  if (!retval && use_ros_)
+  {
+    bool poor_measured_motor_voltage = false;
+    double max_pwm_ratio = double(0x2700) / double(PWM_MAX);
+    double board_resistance = 5.0;
+    if (!WG0X::initializeMotorModel(hw, "WG006", max_pwm_ratio, board_resistance, poor_measured_motor_voltage)) 
+    {
+      ROS_FATAL("Initializing motor trace failed");
+      sleep(1); // wait for ros to flush rosconsole output
+      return -1;
     }
 
     if (!initializePressure(hw))
@@ -303,7 +418,10 @@ bool WG06::initializePressure(pr2_hardware_interface::HardwareInterface *hw)
   string topic = "pressure";
   if (!actuator_.name_.empty())
     topic = topic + "/" + string(actuator_.name_);
-  pressure_publisher_ = new realtime_tools::RealtimePublisher<pr2_msgs::PressureState>(ros::NodeHandle(), topic, 1);
+  pressure_publisher_ = new ethercat_hardware::ExecutorPublisher<pr2_msgs::PressureState>(ros::NodeHandle(), topic, 1);
+  // Size message once, so realtime loop only needs to copy cell data
+  pressure_publisher_->msg_.l_finger_tip.resize(NUM_PRESSURE_REGIONS);
+  pressure_publisher_->msg_.r_finger_tip.resize(NUM_PRESSURE_REGIONS);
   
   // Register pressure sensor with pr2_hardware_interface::HardwareInterface
   for (int i = 0; i < 2; ++i) 
@@ -317,6 +435,200 @@ bool WG06::initializePressure(pr2_hardware_interface::HardwareInterface *hw)
     }
   }
 
+  if (!initializePressureCalibration(hw))
+  {
+    return false;
+  }
+
+  if (!initializePressureContact(hw))
+  {
+    return false;
+  }
+
+  return true;
+}
+
+
+/*!
+ * \brief Sets up optional fingertip contact detection from 'pressure_contact' rosparams
+ *
+ * Detection is only enabled when ~<actuator name>/pressure_contact namespace exists.  It can contain :
+ *  threshold    : total force needed to flag contact (default 1.0)
+ *  zero_samples : number of pressure readings averaged into baseline (default 10)
+ * 
+ * Baseline is measured at startup, and again on rising edge of <actuator name>_pressure_zero digital out.
+ *
+ * \return True, if there are no problems.
+ */
+bool WG06::initializePressureContact(pr2_hardware_interface::HardwareInterface *hw)
+{
+  if (actuator_.name_.empty())
+  {
+    return true;
+  }
+
+  ros::NodeHandle nh("~" + string(actuator_.name_));
+  if (!nh.hasParam("pressure_contact"))
+  {
+    return true;
+  }
+  ros::NodeHandle contact_nh(nh, "pressure_contact");
+
+  double threshold;
+  int zero_samples;
+  contact_nh.param("threshold", threshold, 1.0);
+  contact_nh.param("zero_samples", zero_samples, 10);
+  if (zero_samples < 1)
+  {
+    ROS_FATAL("pressure_contact/zero_samples must be at least 1");
+    return false;
+  }
+
+  for (int i = 0; i < 2; ++i) 
+  {
+    ethercat_hardware::FingertipContact &contact(fingertip_contact_[i]);
+    // Right fingertip is mirror image of left, same as fingertip_pressure sensor_info
+    contact.setOrientation(i ? -1 : 1);
+    contact.setThreshold(threshold);
+    contact.setZeroSamples(zero_samples);
+    contact.zero();
+
+    pr2_hardware_interface::AnalogIn &analog_in(pressure_contact_analog_in_[i]);
+    analog_in.name_ = pressure_sensors_[i].name_ + "_contact";
+    analog_in.state_.state_.resize(ethercat_hardware::FingertipContact::NUM_OUTPUTS);
+    if (hw && !hw->addAnalogIn(&analog_in))
+    {
+      ROS_FATAL("An analog in of the name '%s' already exists.  Device #%02d has a duplicate name",
+                analog_in.name_.c_str(), sh_->get_ring_position());
+      return false;
+    }
+  }
+
+  pressure_zero_digital_out_.name_ = actuator_.name_ + "_pressure_zero";
+  pressure_zero_digital_out_.command_.data_ = 0;
+  pressure_zero_digital_out_.state_.data_ = 1;
+  if (hw && !hw->addDigitalOut(&pressure_zero_digital_out_))
+  {
+    ROS_FATAL("A digital out of the name '%s' already exists.  Device #%02d has a duplicate name", 
+              pressure_zero_digital_out_.name_.c_str(), sh_->get_ring_position());
+    return false;
+  }
+
+  enable_pressure_contact_ = true;
+  return true;
+}
+
+
+/*!
+ * \brief Updates fingertip contact estimates with newest pressure data
+ */
+void WG06::updatePressureContact()
+{
+  uint8_t zero_command = pressure_zero_digital_out_.command_.data_;
+  bool zeroing = false;
+  for (int i = 0; i < 2; ++i) 
+  {
+    ethercat_hardware::FingertipContact &contact(fingertip_contact_[i]);
+    if (zero_command && !last_pressure_zero_command_)
+    {
+      contact.zero();
+    }
+    contact.update(pressure_decoder_.raw(i));
+    contact.getOutputs(&pressure_contact_analog_in_[i].state_.state_[0]);
+    zeroing |= contact.isZeroing();
+  }
+  last_pressure_zero_command_ = zero_command;
+  pressure_zero_digital_out_.state_.data_ = zeroing;
+}
+
+
+static bool getPressureCalibrationArray(XmlRpc::XmlRpcValue &params, const std::string &name, double *results, unsigned len)
+{
+  if (!params.hasMember(name))
+  {
+    ROS_ERROR("Expected pressure_calibration to have '%s' element", name.c_str());
+    return false;
+  }
+  XmlRpc::XmlRpcValue &values(params[name]);
+  if ((values.getType() != XmlRpc::XmlRpcValue::TypeArray) || (values.size() != int(len)))
+  {
+    ROS_ERROR("Expected pressure_calibration '%s' to be list with %d elements", name.c_str(), len);
+    return false;
+  }
+  for (unsigned i=0; i<len; ++i)
+  {
+    if (values[i].getType() == XmlRpc::XmlRpcValue::TypeDouble)
+    {
+      results[i] = static_cast<double>(values[i]);
+    }
+    else if (values[i].getType() == XmlRpc::XmlRpcValue::TypeInt)
+    {
+      results[i] = static_cast<int>(values[i]);
+    }
+    else
+    {
+      ROS_ERROR("Expected pressure_calibration %s[%d] to be floating point type", name.c_str(), i);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/*!
+ * \brief Loads optional per-cell pressure calibration
+ *
+ * Calibration is taken from ~<actuator name>/pressure_calibration, which should have 
+ * l_finger_tip_offsets, l_finger_tip_gains, r_finger_tip_offsets, and r_finger_tip_gains, 
+ * each a list of 22 values.  Calibrated value of each cell is (raw - offset) * gain.
+ * 
+ * When calibration is present, calibrated values are provided to controllers as
+ * AnalogIns named <pressure sensor name>_calibrated.
+ *
+ * \return True, if there are no problems.
+ */
+bool WG06::initializePressureCalibration(pr2_hardware_interface::HardwareInterface *hw)
+{
+  if (actuator_.name_.empty())
+  {
+    return true;
+  }
+
+  ros::NodeHandle nh("~" + string(actuator_.name_));
+  XmlRpc::XmlRpcValue params;
+  if (!nh.getParam("pressure_calibration", params))
+  {
+    return true;
+  }
+  if (params.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    ROS_FATAL("Expected pressure_calibration to be struct type");
+    return false;
+  }
+
+  for (unsigned i = 0; i < 2; ++i) 
+  {
+    string prefix(i ? "r_finger_tip" : "l_finger_tip");
+    double offsets[NUM_PRESSURE_REGIONS];
+    double gains[NUM_PRESSURE_REGIONS];
+    if (!getPressureCalibrationArray(params, prefix + "_offsets", offsets, NUM_PRESSURE_REGIONS) ||
+        !getPressureCalibrationArray(params, prefix + "_gains", gains, NUM_PRESSURE_REGIONS))
+    {
+      return false;
+    }
+    pressure_decoder_.setCalibration(i, offsets, gains);
+
+    pr2_hardware_interface::AnalogIn &analog_in(pressure_calibrated_analog_in_[i]);
+    analog_in.name_ = pressure_sensors_[i].name_ + "_calibrated";
+    analog_in.state_.state_.resize(NUM_PRESSURE_REGIONS);
+    if (hw && !hw->addAnalogIn(&analog_in))
+    {
+      ROS_FATAL("An analog in of the name '%s' already exists.  Device #%02d has a duplicate name",
+                analog_in.name_.c_str(), sh_->get_ring_position());
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -328,7 +640,16 @@ bool WG06::initializeAccel(pr2_hardware_interface::HardwareInterface *hw)
   {
     topic = topic + "/" + string(actuator_.name_);
   }
-  accel_publisher_ = new realtime_tools::RealtimePublisher<pr2_msgs::AccelerometerState>(ros::NodeHandle(), topic, 1);
+  accel_publisher_ = new ethercat_hardware::ExecutorPublisher<pr2_msgs::AccelerometerState>(ros::NodeHandle(), topic, 1);
+
+  // Frame id never changes and status holds at most 4 samples, 
+  // so set frame and make room for samples once, instead of every cycle
+  string frame_id = string(actuator_info_.name_) + "_accelerometer_link";
+  accelerometer_.state_.frame_id_ = frame_id;
+  accelerometer_.state_.samples_.reserve(4);
+  accel_publisher_->msg_.header.frame_id = frame_id;
+  accel_publisher_->msg_.samples.reserve(4);
+  hw_ = hw;
   
   // Register accelerometer with pr2_hardware_interface::HardwareInterface
   accelerometer_.name_ = actuator_info_.name_;
@@ -337,6 +658,32 @@ bool WG06::initializeAccel(pr2_hardware_interface::HardwareInterface *hw)
     ROS_FATAL("An accelerometer of the name '%s' already exists.  Device #%02d has a duplicate name", accelerometer_.name_.c_str(), sh_->get_ring_position());
     return false;
   }
+
+  // Optionally stream every accelerometer sample to non-realtime thread
+  if (!actuator_.name_.empty())
+  {
+    ros::NodeHandle nh("~" + string(actuator_.name_));
+    bool enable_stream = false;
+    nh.param("accel_stream", enable_stream, false);
+    if (enable_stream)
+    {
+      int capacity;
+      double publish_period;
+      nh.param("accel_stream_capacity", capacity, 4096);
+      nh.param("accel_stream_publish_period", publish_period, 0.01);
+      if (capacity <= 0)
+      {
+        ROS_FATAL("%s : accel_stream_capacity must be positive, not %d", actuator_.name_.c_str(), capacity);
+        return false;
+      }
+      accel_stream_ = new ethercat_hardware::AccelSampleStream();
+      if (!accel_stream_->initialize("raw_accelerometer_stream/" + string(actuator_.name_), capacity, publish_period))
+      {
+        return false;
+      }
+    }
+  }
+
   return true;
 }
 
@@ -353,15 +700,18 @@ bool WG06::initializeFT(pr2_hardware_interface::HardwareInterface *hw)
 
   // FT provides 6 values : 3 Forces + 3 Torques
   ft_raw_analog_in_.state_.state_.resize(6); 
-  // FT usually provides 3-4 new samples per cycle
+  // FT usually provides 3-4 new samples every millisecond
   force_torque_.state_.samples_.reserve(4);
+
+  // When realtime loop runs faster than FT sample rate, some cycles will not have a new sample
+  max_ft_empty_cycles_ = unsigned(ceil(FT_MIN_SAMPLE_PERIOD / cycle_period_ - 1e-6)) - 1;
   force_torque_.state_.good_ = true;
 
   // For now publish RAW F/T values for engineering purposes.  In future this publisher may be disabled by default.
   std::string topic = "raw_ft";
   if (!actuator_.name_.empty())
     topic = topic + "/" + string(actuator_.name_);
-  raw_ft_publisher_ = new realtime_tools::RealtimePublisher<ethercat_hardware::RawFTData>(ros::NodeHandle(), topic, 1);
+  raw_ft_publisher_ = new ethercat_hardware::ExecutorPublisher<ethercat_hardware::RawFTData>(ros::NodeHandle(), topic, 1);
   if (raw_ft_publisher_ == NULL)
   {
     ROS_FATAL("Could not allocate raw_ft publisher");
@@ -370,6 +720,33 @@ bool WG06::initializeFT(pr2_hardware_interface::HardwareInterface *hw)
   // Allocate space for raw f/t data values
   raw_ft_publisher_->msg_.samples.reserve(MAX_FT_SAMPLES);
 
+  // Optionally stream every raw sample to non-realtime thread, so none are lost when publisher is busy
+  {
+    ros::NodeHandle nh("~" + string(actuator_.name_));
+    bool enable_stream = false;
+    nh.param("ft_stream", enable_stream, false);
+    if (enable_stream)
+    {
+      int capacity;
+      double publish_period;
+      nh.param("ft_stream_capacity", capacity, 4096);
+      nh.param("ft_stream_publish_period", publish_period, 0.01);
+      if (capacity <= 0)
+      {
+        ROS_FATAL("%s : ft_stream_capacity must be positive, not %d", actuator_.name_.c_str(), capacity);
+        return false;
+      }
+      topic = "raw_ft_stream";
+      if (!actuator_.name_.empty())
+        topic = topic + "/" + string(actuator_.name_);
+      ft_stream_ = new ethercat_hardware::FTSampleStream();
+      if (!ft_stream_->initialize(topic, capacity, publish_period))
+      {
+        return false;
+      }
+    }
+  }
+
   force_torque_.command_.halt_on_error_ = false;
   force_torque_.state_.good_ = true;
 
@@ -386,7 +763,7 @@ bool WG06::initializeFT(pr2_hardware_interface::HardwareInterface *hw)
       topic = "ft";
       if (!actuator_.name_.empty())
         topic = topic + "/" + string(actuator_.name_);
-      ft_publisher_ = new realtime_tools::RealtimePublisher<geometry_msgs::WrenchStamped>(ros::NodeHandle(), topic, 1);
+      ft_publisher_ = new ethercat_hardware::ExecutorPublisher<geometry_msgs::WrenchStamped>(ros::NodeHandle(), topic, 1);
       if (ft_publisher_ == NULL)
       {
         ROS_FATAL("Could not allocate ft publisher");
@@ -403,6 +780,162 @@ bool WG06::initializeFT(pr2_hardware_interface::HardwareInterface *hw)
     }
   }
 
+  // Fold gains, offsets, and calibration matrix into transform used every cycle
+  ft_calibration_.configure(ft_params_.calibration_coeff_, ft_params_.offsets_, ft_params_.gains_, ft_overload_limit_);
+
+  if (!initializeFTFilter(hw))
+  {
+    return false;
+  }
+
+  return true;
+}
+
+
+static bool getFilterDouble(XmlRpc::XmlRpcValue &value, double &result)
+{
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeDouble)
+  {
+    result = static_cast<double>(value);
+    return true;
+  }
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+  {
+    result = static_cast<int>(value);
+    return true;
+  }
+  return false;
+}
+
+
+/*!
+ * \brief Sets up optional filtering of F/T data from 'ft_filter' rosparams
+ *
+ * Filter is only enabled when ~<actuator name>/ft_filter namespace exists.  It can contain :
+ *  biquads        : list of [b0, b1, b2, a1, a2] sections (normalized so a0=1)
+ *  lowpass_cutoff : if given, adds low-pass sections with this cutoff (Hz)
+ *  lowpass_q      : quality factor of low-pass sections (default sqrt(0.5))
+ *  lowpass_sections : number of low-pass sections to cascade (default 1)
+ *  sample_rate    : F/T sample rate in Hz, required for lowpass_cutoff
+ *  decimation     : number of samples averaged into each output sample (default 1)
+ *  tare_samples   : number of output samples averaged to estimate bias (default 100)
+ *
+ * \return True, if there are no problems.
+ */
+bool WG06::initializeFTFilter(pr2_hardware_interface::HardwareInterface *hw)
+{
+  if (actuator_.name_.empty())
+  {
+    return true;
+  }
+
+  ros::NodeHandle nh("~" + string(actuator_.name_));
+  if (!nh.hasParam("ft_filter"))
+  {
+    return true;
+  }
+  ros::NodeHandle filter_nh(nh, "ft_filter");
+
+  ft_filter_.clearBiquads();
+  XmlRpc::XmlRpcValue biquads;
+  if (filter_nh.getParam("biquads", biquads))
+  {
+    if (biquads.getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+      ROS_FATAL("Expected ft_filter/biquads to be list type");
+      return false;
+    }
+    for (int i=0; i<biquads.size(); ++i)
+    {
+      XmlRpc::XmlRpcValue &section(biquads[i]);
+      double c[5];
+      if ((section.getType() != XmlRpc::XmlRpcValue::TypeArray) || (section.size() != 5))
+      {
+        ROS_FATAL("Expected ft_filter/biquads[%d] to be list of 5 elements : [b0, b1, b2, a1, a2]", i);
+        return false;
+      }
+      for (int j=0; j<5; ++j)
+      {
+        if (!getFilterDouble(section[j], c[j]))
+        {
+          ROS_FATAL("Expected ft_filter/biquads[%d][%d] to be floating point type", i, j);
+          return false;
+        }
+      }
+      ethercat_hardware::FTFilter::Biquad biquad = {c[0], c[1], c[2], c[3], c[4]};
+      if (!ft_filter_.addBiquad(biquad))
+      {
+        ROS_FATAL("F/T filter supports at most %d biquad sections", ethercat_hardware::FTFilter::MAX_BIQUADS);
+        return false;
+      }
+    }
+  }
+
+  double lowpass_cutoff;
+  if (filter_nh.getParam("lowpass_cutoff", lowpass_cutoff))
+  {
+    double sample_rate, lowpass_q;
+    int lowpass_sections;
+    if (!filter_nh.getParam("sample_rate", sample_rate))
+    {
+      ROS_FATAL("ft_filter/lowpass_cutoff also requires ft_filter/sample_rate");
+      return false;
+    }
+    filter_nh.param("lowpass_q", lowpass_q, sqrt(0.5));
+    filter_nh.param("lowpass_sections", lowpass_sections, 1);
+    if ((lowpass_cutoff <= 0.0) || (lowpass_cutoff >= sample_rate / 2.0) || (lowpass_q <= 0.0))
+    {
+      ROS_FATAL("ft_filter/lowpass_cutoff %f must be between 0 and half of sample_rate %f, and lowpass_q must be positive", 
+                lowpass_cutoff, sample_rate);
+      return false;
+    }
+    ethercat_hardware::FTFilter::Biquad biquad = 
+      ethercat_hardware::FTFilter::lowpass(lowpass_cutoff, lowpass_q, sample_rate);
+    for (int i=0; i<lowpass_sections; ++i)
+    {
+      if (!ft_filter_.addBiquad(biquad))
+      {
+        ROS_FATAL("F/T filter supports at most %d biquad sections", ethercat_hardware::FTFilter::MAX_BIQUADS);
+        return false;
+      }
+    }
+  }
+
+  int decimation, tare_samples;
+  filter_nh.param("decimation", decimation, 1);
+  filter_nh.param("tare_samples", tare_samples, 100);
+  if ((decimation < 1) || (tare_samples < 1))
+  {
+    ROS_FATAL("ft_filter/decimation and ft_filter/tare_samples must be at least 1");
+    return false;
+  }
+  ft_filter_.setDecimation(decimation);
+  ft_filter_.setTareSamples(tare_samples);
+
+  filtered_force_torque_.name_ = actuator_.name_ + "_filtered";
+  filtered_force_torque_.state_.samples_.reserve(MAX_FT_SAMPLES);
+  filtered_force_torque_.state_.good_ = true;
+  filtered_force_torque_.command_.halt_on_error_ = false;
+  if (hw && !hw->addForceTorque(&filtered_force_torque_))
+  {
+    ROS_FATAL("A force/torque sensor of the name '%s' already exists.  Device #%02d has a duplicate name", 
+              filtered_force_torque_.name_.c_str(), sh_->get_ring_position());
+    return false;
+  }
+
+  ft_tare_digital_out_.name_ = actuator_.name_ + "_ft_tare";
+  ft_tare_digital_out_.command_.data_ = 0;
+  ft_tare_digital_out_.state_.data_ = 0;
+  if (hw && !hw->addDigitalOut(&ft_tare_digital_out_))
+  {
+    ROS_FATAL("A digital out of the name '%s' already exists.  Device #%02d has a duplicate name", 
+              ft_tare_digital_out_.name_.c_str(), sh_->get_ring_position());
+    return false;
+  }
+
+  ROS_INFO("%s : F/T filter with %d biquad sections, decimation %d", 
+           actuator_.name_.c_str(), ft_filter_.numBiquads(), ft_filter_.decimation());
+  enable_ft_filter_ = true;
   return true;
 }
 
@@ -549,26 +1082,36 @@ bool WG06::unpackPressure(unsigned char *pressure_buf)
   else 
   {
     WG06Pressure *p( (WG06Pressure *) pressure_buf);
-    for (int i = 0; i < 22; ++i ) {
-      pressure_sensors_[0].state_.data_[i] =
-        ((p->l_finger_tip_[i] >> 8) & 0xff) |
-        ((p->l_finger_tip_[i] << 8) & 0xff00);
-      pressure_sensors_[1].state_.data_[i] =
-        ((p->r_finger_tip_[i] >> 8) & 0xff) |
-        ((p->r_finger_tip_[i] << 8) & 0xff00);
+
+    // Left and right fingertip cells are contiguous, so they are decoded together
+    BOOST_STATIC_ASSERT(offsetof(WG06Pressure, r_finger_tip_) == 
+                        offsetof(WG06Pressure, l_finger_tip_) + sizeof(p->l_finger_tip_));
+    pressure_decoder_.decode(pressure_buf + offsetof(WG06Pressure, l_finger_tip_));
+
+    const size_t cell_bytes = NUM_PRESSURE_REGIONS * sizeof(uint16_t);
+    for (int i = 0; i < 2; ++i ) 
+    {
+      memcpy(&pressure_sensors_[i].state_.data_[0], pressure_decoder_.raw(i), cell_bytes);
+      if (pressure_decoder_.hasCalibration())
+      {
+        memcpy(&pressure_calibrated_analog_in_[i].state_.state_[0], pressure_decoder_.calibrated(i), 
+               NUM_PRESSURE_REGIONS * sizeof(double));
+      }
     }
 
     if (p->timestamp_ != last_pressure_time_)
     {
+      if (enable_pressure_contact_)
+      {
+        updatePressureContact();
+      }
+
       if (pressure_publisher_ && pressure_publisher_->trylock())
       {
+        // Message vectors are sized in initializePressure(), cells are copied as one block
         pressure_publisher_->msg_.header.stamp = ros::Time::now();
-        pressure_publisher_->msg_.l_finger_tip.resize(22);
-        pressure_publisher_->msg_.r_finger_tip.resize(22);
-        for (int i = 0; i < 22; ++i ) {
-          pressure_publisher_->msg_.l_finger_tip[i] = pressure_sensors_[0].state_.data_[i];
-          pressure_publisher_->msg_.r_finger_tip[i] = pressure_sensors_[1].state_.data_[i];
-        }
+        memcpy(&pressure_publisher_->msg_.l_finger_tip[0], pressure_decoder_.raw(0), cell_bytes);
+        memcpy(&pressure_publisher_->msg_.r_finger_tip[0], pressure_decoder_.raw(1), cell_bytes);
         pressure_publisher_->unlockAndPublish();
       }
     }
@@ -588,27 +1131,37 @@ bool WG06::unpackAccel(WG06StatusWithAccel *status, WG06StatusWithAccel *last_st
 {
   int count = uint8_t(status->accel_count_ - last_status->accel_count_);
   accelerometer_samples_ += count;
+  accelerometer_sample_count_ += count;
   // Only most recent 4 samples of accelerometer data is available in status data
-  // 4 samples will be enough with realtime loop running at 1kHz and accelerometer running at 3kHz
+  // Accelerometer runs at 3kHz, so 4 samples will be enough with realtime loop running at 1kHz or faster
   // If count is greater than 4, then some data has been "missed".
   accelerometer_missed_samples_ += (count > 4) ? (count-4) : 0; 
   count = min(4, count);
+
+  // Space for 4 samples is reserved in initializeAccel(), so this never allocates
   accelerometer_.state_.samples_.resize(count);
-  accelerometer_.state_.frame_id_ = string(actuator_info_.name_) + "_accelerometer_link";
   for (int i = 0; i < count; ++i)
   {
-    int32_t acc = status->accel_[count - i - 1];
-    int range = (acc >> 30) & 3;
-    float d = 1 << (8 - range);
-    accelerometer_.state_.samples_[i].x = 9.81 * ((((acc >>  0) & 0x3ff) << 22) >> 22) / d;
-    accelerometer_.state_.samples_[i].y = 9.81 * ((((acc >> 10) & 0x3ff) << 22) >> 22) / d;
-    accelerometer_.state_.samples_[i].z = 9.81 * ((((acc >> 20) & 0x3ff) << 22) >> 22) / d;
+    // Newest sample is at index 0
+    ethercat_hardware::AccelSample sample;
+    sample.raw_ = status->accel_[count - i - 1];
+    geometry_msgs::Vector3 &v(accelerometer_.state_.samples_[i]);
+    sample.decode(v.x, v.y, v.z);
+  }
+
+  if (accel_stream_ != NULL)
+  {
+    for (int i = count-1; i >= 0; --i)
+    {
+      ethercat_hardware::AccelSample sample;
+      sample.raw_ = status->accel_[i];
+      accel_stream_->push(accelerometer_sample_count_ - i, sample);
+    }
   }
 
   if (accel_publisher_->trylock())
   {
-    accel_publisher_->msg_.header.frame_id = accelerometer_.state_.frame_id_;
-    accel_publisher_->msg_.header.stamp = ros::Time::now();
+    accel_publisher_->msg_.header.stamp = hw_ ? hw_->current_time_ : ros::Time::now();
     accel_publisher_->msg_.samples.resize(count);
     for (int i = 0; i < count; ++i)
     {
@@ -622,83 +1175,6 @@ bool WG06::unpackAccel(WG06StatusWithAccel *status, WG06StatusWithAccel *last_st
 }
 
 
-/*!
- * \brief Convert FTDataSample to Wrench using gain, offset, and coefficient matrix
- * 
- * perform offset and gains multiplication on raw data
- * and then multiply by calibration matrix to get force and torque values.
- * The calibration matrix is based on "raw"  deltaR/R values from strain gauges
- *
- * Force/Torque = Coeff * ADCVoltage
- *
- * Coeff = RawCoeff / ( ExcitationVoltage * AmplifierGain )
- *       = RawCoeff / ( 2.5V * AmplifierGain )
- *
- * ADCVoltage = Vref / 2^16 
- *            = 2.5 / 2^16
- * 
- * Force/Torque =  RawCalibrationCoeff / ( ExcitationVoltage * AmplifierGain ) * (ADCValues * 2.5V/2^16)
- *              = (RawCalibration * ADCValues) / (AmplifierGain * 2^16)
- * 
- * Note on hardware circuit and Vref and excitation voltage should have save value.  
- * Thus, with Force/Torque calculation they cancel out. 
- */
-void WG06::convertFTDataSampleToWrench(const FTDataSample &sample, geometry_msgs::Wrench &wrench)
-{
-  // Apply gains / offset to F/T raw analog inputs
-  // Also, make sure values are within bounds.  
-  // Out-of-bound values indicate a broken sensor or an overload.
-  double in[6];
-  for (unsigned i=0; i<6; ++i)
-  {
-    int raw_data = sample.data_[i];
-    if (abs(raw_data) > ft_overload_limit_)
-    {
-      ft_overload_flags_ |= (1<<i);
-    }
-    in[i] = (double(raw_data) - ft_params_.offset(i)) / ( ft_params_.gain(i) * double(1<<16) );
-  }
-
-  // Vhalf ADC measurement should be amost half the ADC reference voltage
-  // For a 16bit ADC the Vhalf value should be about (1<<16)/2
-  // If Vhalf value is not close to this, this could mean 1 of 2 things:
-  //   1. WG035 electronics are damaged some-how 
-  //   2. WG035 is not present or disconnected gripper MCB 
-  if ( abs( int(sample.vhalf_) - FT_VHALF_IDEAL) > FT_VHALF_RANGE )
-  {
-    if ((sample.vhalf_ == 0x0000) || (sample.vhalf_ == 0xFFFF))
-    {
-      // When WG035 MCB is not present the DATA line floats low or high and all 
-      // reads through SPI interface return 0.
-      ft_disconnected_ = true;
-    }
-    else 
-    {
-      ft_vhalf_error_ = true;
-    }
-  }
-
-  // Apply coeffiecient matrix multiplication to raw inputs to get force/torque values
-  double out[6];
-  for (unsigned i=0; i<6; ++i)
-  {
-    double sum=0.0;
-    for (unsigned j=0; j<6; ++j)
-    {
-      sum += ft_params_.calibration_coeff(i,j) * in[j];
-    }
-    out[i] = sum;
-  }
-
-  wrench.force.x  = out[0];
-  wrench.force.y  = out[1];
-  wrench.force.z  = out[2];
-  wrench.torque.x = out[3];
-  wrench.torque.y = out[4];
-  wrench.torque.z = out[5];
-}
-
-
 /*!
  * \brief Unpack force/torque ADC samples from realtime data.
  *
@@ -727,10 +1203,26 @@ bool WG06::unpackFT(WG06StatusWithAccelAndFT *status, WG06StatusWithAccelAndFT *
   ft_missed_samples_ += missed_samples;
   unsigned usable_samples = min(new_samples, MAX_FT_SAMPLES); 
 
-  // Also, if number of new_samples is ever 0, then there is also an error
+  // Also, if there are no new samples for longer than FT sample period, then there is also an error
   if (usable_samples == 0)
   {
-    ft_sampling_rate_error_ = true;
+    if (++ft_empty_cycles_ > max_ft_empty_cycles_)
+    {
+      ft_sampling_rate_error_ = true;
+    }
+  }
+  else
+  {
+    ft_empty_cycles_ = 0;
+  }
+
+  // Hand every new sample to lossless stream, oldest first
+  if (ft_stream_ != NULL)
+  {
+    for (int sample_num=usable_samples-1; sample_num>=0; --sample_num)
+    {
+      ft_stream_->push(ft_sample_count_ - sample_num, status->ft_samples_[sample_num]);
+    }
   }
 
   // Make room in data structure for more f/t samples
@@ -745,14 +1237,32 @@ bool WG06::unpackFT(WG06StatusWithAccelAndFT *status, WG06StatusWithAccelAndFT *
                      (!ft_disconnected_) && 
                      (!ft_vhalf_error_) );
 
+  // Convert all new samples at once, out-of-bound values indicate a broken sensor or an overload.
+  double wrenches[MAX_FT_SAMPLES][NUM_FT_CHANNELS];
+  ethercat_hardware::FTSampleErrors ft_errors;
+  ft_calibration_.convert(status->ft_samples_, usable_samples, wrenches, ft_errors);
+  ft_overload_flags_ |= ft_errors.overload_flags_;
+  ft_disconnected_ |= ft_errors.disconnected_;
+  ft_vhalf_error_ |= ft_errors.vhalf_error_;
+
   for (unsigned sample_index=0; sample_index<usable_samples; ++sample_index)
   {
     // samples are stored in status data, so that newest sample is at index 0.
     // this is the reverse of the order data is stored in hardware_interface::ForceTorque buffer.
     unsigned status_sample_index = usable_samples-sample_index-1;
-    const FTDataSample &sample(status->ft_samples_[status_sample_index]); 
+    const double *out = wrenches[status_sample_index];
     geometry_msgs::Wrench &wrench(ft_state.samples_[sample_index]);
-    convertFTDataSampleToWrench(sample, wrench);
+    wrench.force.x  = out[0];
+    wrench.force.y  = out[1];
+    wrench.force.z  = out[2];
+    wrench.torque.x = out[3];
+    wrench.torque.y = out[4];
+    wrench.torque.z = out[5];
+  }
+
+  if (enable_ft_filter_)
+  {
+    filterFT(wrenches, usable_samples);
   }
 
   // Put newest sample into analog vector for controllers (deprecated)
@@ -805,6 +1315,45 @@ bool WG06::unpackFT(WG06StatusWithAccelAndFT *status, WG06StatusWithAccelAndFT *
 }
 
 
+/*!
+ * \brief Runs new F/T samples through filter, and puts output in filtered_force_torque_
+ *
+ * \param wrenches     converted F/T samples, newest sample first
+ * \param num_samples  number of samples in wrenches
+ */
+void WG06::filterFT(const double (*wrenches)[NUM_FT_CHANNELS], unsigned num_samples)
+{
+  // Rising edge of tare command starts new bias estimate
+  uint8_t tare_command = ft_tare_digital_out_.command_.data_;
+  if (tare_command && !last_ft_tare_command_)
+  {
+    ft_filter_.tare();
+  }
+  last_ft_tare_command_ = tare_command;
+
+  // Decimator produces at most one output per input, so this never exceeds reserved space
+  pr2_hardware_interface::ForceTorqueState &state(filtered_force_torque_.state_);
+  state.samples_.clear();
+  for (int status_sample_index=num_samples-1; status_sample_index>=0; --status_sample_index)
+  {
+    double out[NUM_FT_CHANNELS];
+    if (ft_filter_.filter(wrenches[status_sample_index], out))
+    {
+      state.samples_.resize(state.samples_.size() + 1);
+      geometry_msgs::Wrench &wrench(state.samples_.back());
+      wrench.force.x  = out[0];
+      wrench.force.y  = out[1];
+      wrench.force.z  = out[2];
+      wrench.torque.x = out[3];
+      wrench.torque.y = out[4];
+      wrench.torque.z = out[5];
+    }
+  }
+  state.good_ = force_torque_.state_.good_;
+  ft_tare_digital_out_.state_.data_ = ft_filter_.isTaring();
+}
+
+
 void WG06::multiDiagnostics(vector<diagnostic_msgs::DiagnosticStatus> &vec, unsigned char *buffer)
 {
   diagnostic_updater::DiagnosticStatusWrapper &d(diagnostic_status_);
@@ -879,6 +1428,11 @@ void WG06::diagnosticsAccel(diagnostic_updater::DiagnosticStatusWrapper &d, unsi
   d.addf("Accelerometer bandwidth", "%s (%d)", bandwidth_str, acmd.bandwidth_);
   d.addf("Accelerometer sample frequency", "%f", sample_frequency);
   d.addf("Accelerometer missed samples", "%d", accelerometer_missed_samples_);                                   
+  if (accel_stream_ != NULL)
+  {
+    d.addf("Accelerometer stream published samples", "%llu", (unsigned long long) accel_stream_->publishedCount());
+    d.addf("Accelerometer stream overflows", "%llu", (unsigned long long) accel_stream_->overflowCount());
+  }
 }
 
 
@@ -1022,6 +1576,20 @@ void WG06::diagnosticsFT(diagnostic_updater::DiagnosticStatusWrapper &d, WG06Sta
   //d.addf("F/T sample count", "%llu", ft_sample_count_);
   d.addf("F/T sample frequency", "%.2f (Hz)", sample_frequency);
   d.addf("F/T missed samples", "%llu", ft_missed_samples_);
+  if (enable_ft_filter_)
+  {
+    const double *bias = ft_filter_.bias();
+    d.addf("F/T filter biquads", "%u", ft_filter_.numBiquads());
+    d.addf("F/T filter decimation", "%u", ft_filter_.decimation());
+    d.add("F/T filter taring", ft_filter_.isTaring());
+    d.addf("F/T filter bias", "%f %f %f %f %f %f", bias[0], bias[1], bias[2], bias[3], bias[4], bias[5]);
+  }
+  if (ft_stream_ != NULL)
+  {
+    d.addf("F/T stream capacity", "%u", ft_stream_->capacity());
+    d.addf("F/T stream published samples", "%llu", (unsigned long long) ft_stream_->publishedCount());
+    d.addf("F/T stream overflows", "%llu", (unsigned long long) ft_stream_->overflowCount());
+  }
   std::stringstream ss;
   const FTDataSample &sample(status->ft_samples_[0]);  //use newest data sample
   for (unsigned i=0;i<NUM_FT_CHANNELS;++i)
@@ -154,6 +154,28 @@ void WG0XActuatorInfo::generateCRC(void)
 }
 
 
+WG0XConversionPlan::WG0XConversionPlan() :
+  position_scale_(0.0),
+  current_scale_(0.0),
+  effort_per_amp_(0.0),
+  voltage_scale_(0.0),
+  max_effort_(0.0)
+{
+}
+
+/*!
+ * \brief  Compute conversion factors from actuator and board configuration
+ */
+void WG0XConversionPlan::build(const WG0XActuatorInfo &actuator_info, const WG0XConfigInfo &config_info, double max_current)
+{
+  position_scale_ = 2 * M_PI / actuator_info.pulses_per_revolution_;
+  current_scale_ = config_info.nominal_current_scale_;
+  effort_per_amp_ = actuator_info.motor_torque_constant_ * actuator_info.encoder_reduction_;
+  voltage_scale_ = config_info.nominal_voltage_scale_;
+  max_effort_ = max_current * effort_per_amp_;
+}
+
+
 WG0X::WG0X() :
   max_current_(0.0),
   too_many_dropped_packets_(false),
@@ -164,6 +186,9 @@ WG0X::WG0X() :
   cached_zero_offset_(0), 
   calibration_status_(NO_CALIBRATION),
   app_ram_status_(APP_RAM_MISSING),
+  pre_initialized_(false),
+  app_ram_valid_(false),
+  app_ram_zero_offset_(0.0),
   motor_model_(NULL),
   disable_motor_model_checking_(false)
 {
@@ -244,7 +269,8 @@ bool WG0X::initializeMotorModel(pr2_hardware_interface::HardwareInterface *hw,
   if (!hw) 
     return true;
 
-  motor_model_ = new MotorModel(1000);
+  // Keep one second of motor trace, regardless of realtime loop rate
+  motor_model_ = new MotorModel(unsigned(1.0 / cycle_period_ + 0.5), cycle_period_);
   if (motor_model_ == NULL) 
     return false;
 
@@ -296,13 +322,8 @@ boost::shared_ptr<ethercat_hardware::MotorHeatingModelCommon> WG0X::motor_heatin
 bool WG0X::initializeMotorHeatingModel(bool allow_unprogrammed)
 {
 
-  EthercatDirectCom com(EtherCAT_DataLinkLayer::instance());
-  ethercat_hardware::MotorHeatingModelParametersEepromConfig config;
-  if (!readMotorHeatingModelParametersFromEeprom(&com, config))
-  {
-    ROS_FATAL("Unable to read motor heating model config parameters from EEPROM");
-    return false;
-  }
+  // Parameters were read from EEPROM by preInitialize()
+  const ethercat_hardware::MotorHeatingModelParametersEepromConfig &config(heating_config_);
 
   // All devices need to have motor model heating model parameters stored in them...
   // Even if device doesn't use paramers, they should be there.
@@ -392,7 +413,7 @@ bool WG0X::initializeMotorHeatingModel(bool allow_unprogrammed)
 }
 
 
-int WG0X::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_unprogrammed)
+int WG0X::preInitialize(bool allow_unprogrammed)
 {
   ROS_DEBUG("Device #%02d: WG0%d (%#08x) Firmware Revision %d.%02d, PCB Revision %c.%02d, Serial #: %d", 
             sh_->get_ring_position(),
@@ -428,14 +449,44 @@ int WG0X::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_u
     return -1;
   }
   ROS_DEBUG("            Serial #: %05d", config_info_.device_serial_number_);
-  double board_max_current = double(config_info_.absolute_current_limit_) * config_info_.nominal_current_scale_;
 
   if (!readActuatorInfoFromEeprom(&com, actuator_info_))
   {
     ROS_FATAL("Unable to read actuator info from EEPROM");
     return -1;
   }
-  
+
+  if (actuator_info_.verifyCRC())
+  {
+    actuator_.name_ = actuator_info_.name_;
+
+    if (!readMotorHeatingModelParametersFromEeprom(&com, heating_config_))
+    {
+      ROS_FATAL("Unable to read motor heating model config parameters from EEPROM");
+      return -1;
+    }
+
+    // If it is supported, read application ram data.
+    if (app_ram_status_ == APP_RAM_PRESENT)
+    {
+      app_ram_valid_ = readAppRam(&com, app_ram_zero_offset_);
+    }
+  }
+
+  pre_initialized_ = true;
+  return 0;
+}
+
+int WG0X::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_unprogrammed)
+{
+  // Configuration may already have been read while other devices were being read
+  if (!pre_initialized_ && (preInitialize(allow_unprogrammed) != 0))
+  {
+    return -1;
+  }
+
+  double board_max_current = double(config_info_.absolute_current_limit_) * config_info_.nominal_current_scale_;
+
   if (actuator_info_.verifyCRC())
   {
     if (actuator_info_.major_ != 0 || actuator_info_.minor_ != 2)
@@ -449,7 +500,6 @@ int WG0X::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_u
       }
     }
 
-    actuator_.name_ = actuator_info_.name_;
     ROS_DEBUG("            Name: %s", actuator_info_.name_);
 
     // Copy actuator info read from eeprom, into msg type
@@ -471,6 +521,15 @@ int WG0X::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_u
           return -1;
       }
 
+      velocity_estimate_analog_in_.name_ = actuator_.name_ + "_velocity_estimate";
+      velocity_estimate_analog_in_.state_.state_.resize(3);
+      if (hw && !hw->addAnalogIn(&velocity_estimate_analog_in_))
+      {
+          ROS_FATAL("An analog in of the name '%s' already exists.  Device #%02d has a duplicate name", 
+                    velocity_estimate_analog_in_.name_.c_str(), sh_->get_ring_position());
+          return -1;
+      }
+
     }
 
     // Register digital out with pr2_hardware_interface::HardwareInterface
@@ -481,15 +540,14 @@ int WG0X::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_u
         return -1;
     }
 
-    // If it is supported, read application ram data.
+    // Use calibration read from application ram, if any
     if (app_ram_status_ == APP_RAM_PRESENT)
     {
-      double zero_offset;
-      if (readAppRam(&com, zero_offset))
+      if (app_ram_valid_)
       {
-        ROS_DEBUG("Read calibration from device %s: %f", actuator_info_.name_, zero_offset);
-        actuator_.state_.zero_offset_ = zero_offset;
-        cached_zero_offset_ = zero_offset;
+        ROS_DEBUG("Read calibration from device %s: %f", actuator_info_.name_, app_ram_zero_offset_);
+        actuator_.state_.zero_offset_ = app_ram_zero_offset_;
+        cached_zero_offset_ = app_ram_zero_offset_;
         calibration_status_ = SAVED_CALIBRATION;
       }
       else
@@ -530,6 +588,8 @@ int WG0X::initialize(pr2_hardware_interface::HardwareInterface *hw, bool allow_u
     return -1;
   }
 
+  conversion_.build(actuator_info_, config_info_, max_current_);
+
   return 0;
 }
 
@@ -632,32 +692,29 @@ bool WG0X::unpackState(unsigned char *this_buffer, unsigned char *prev_buffer)
   state.device_id_ = sh_->get_ring_position();
   
   state.encoder_count_ = this_status->encoder_count_;
-  state.position_ = double(this_status->encoder_count_) / actuator_info_.pulses_per_revolution_ * 2 * M_PI - state.zero_offset_;
+  conversion_.convert(*this_status, state);
   
   state.encoder_velocity_ = 
     calcEncoderVelocity(this_status->encoder_count_, this_status->timestamp_,
                         prev_status->encoder_count_, prev_status->timestamp_);
-  state.velocity_ = state.encoder_velocity_ / actuator_info_.pulses_per_revolution_ * 2 * M_PI;
+  state.velocity_ = state.encoder_velocity_ * conversion_.position_scale_;
+
+  velocity_estimator_.update(this_status->encoder_count_, this_status->timestamp_);
+  std::vector<double> &estimate(velocity_estimate_analog_in_.state_.state_);
+  if (estimate.size() == 3)
+  {
+    estimate[0] = velocity_estimator_.velocity();
+    estimate[1] = velocity_estimator_.velocity() * conversion_.position_scale_;
+    estimate[2] = velocity_estimator_.window();
+  }
 
   state.calibration_reading_ = this_status->calibration_reading_ & LIMIT_SENSOR_0_STATE;
   state.calibration_rising_edge_valid_ = this_status->calibration_reading_ &  LIMIT_OFF_TO_ON;
   state.calibration_falling_edge_valid_ = this_status->calibration_reading_ &  LIMIT_ON_TO_OFF;
-  state.last_calibration_rising_edge_ = double(this_status->last_calibration_rising_edge_) / actuator_info_.pulses_per_revolution_ * 2 * M_PI;
-  state.last_calibration_falling_edge_ = double(this_status->last_calibration_falling_edge_) / actuator_info_.pulses_per_revolution_ * 2 * M_PI;
   state.is_enabled_ = bool(this_status->mode_ & MODE_ENABLE);
 
-  state.last_executed_current_ = this_status->programmed_current_ * config_info_.nominal_current_scale_;
-  state.last_measured_current_ = this_status->measured_current_ * config_info_.nominal_current_scale_;
-
-  state.last_executed_effort_ = this_status->programmed_current_ * config_info_.nominal_current_scale_ * actuator_info_.motor_torque_constant_ * actuator_info_.encoder_reduction_;
-  state.last_measured_effort_ = this_status->measured_current_ * config_info_.nominal_current_scale_ * actuator_info_.motor_torque_constant_ * actuator_info_.encoder_reduction_;
-
   state.num_encoder_errors_ = this_status->num_encoder_errors_;
 
-  state.motor_voltage_ = this_status->motor_voltage_ * config_info_.nominal_voltage_scale_;
-
-  state.max_effort_ = max_current_ * actuator_info_.encoder_reduction_ * actuator_info_.motor_torque_constant_; 
-
   return verifyState(this_status, prev_status);
 }
 
@@ -755,7 +812,7 @@ bool WG0X::verifyState(WG0XStatus *this_status, WG0XStatus *prev_status)
   {
     // Both motor model and motor heating model use MotorTraceSample
     ethercat_hardware::MotorTraceSample &s(motor_trace_sample_);
-    double last_executed_current =  this_status->programmed_current_ * config_info_.nominal_current_scale_;
+    double last_executed_current =  this_status->programmed_current_ * conversion_.current_scale_;
     double supply_voltage = double(prev_status->supply_voltage_) * config_info_.nominal_voltage_scale_;
     double pwm_ratio = double(this_status->programmed_pwm_value_) / double(PWM_MAX);
     s.timestamp        = state.timestamp_;
@@ -861,7 +918,7 @@ end:
         reason = (undervoltage) ? "Undervoltage Lockout" : "Safety Lockout";
       }    
       int level          = (new_error) ? 2 : 0;
-      motor_model_->flagPublish(reason, level , 100);
+      motor_model_->flagPublish(reason, level , motor_model_->cycles(0.1));
       publish_motor_trace_.command_.data_ = 0;
     }
   }
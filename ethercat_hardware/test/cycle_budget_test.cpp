@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+#include "ethercat_hardware/motor_model.h"
+#include "ethercat_hardware/wg0x.h"
+#include "ethercat_hardware/wg06.h"
+#include "ethercat_hardware/wg021.h"
+#include "ethercat_hardware/wg_util.h"
+#include "ethercat_hardware/ft_calibration.h"
+#include "ethercat_hardware/ft_filter.h"
+#include "ethercat_hardware/pressure_decoder.h"
+#include "test_timing.h"
+
+using ethercat_hardware::FTCalibration;
+using ethercat_hardware::FTSampleErrors;
+using ethercat_hardware::FTFilter;
+using ethercat_hardware::PressureDecoder;
+
+
+// Chain of a PR2 : motor boards, two grippers, projector board
+static const unsigned NUM_WG05 = 19;
+static const unsigned NUM_WG06 = 2;
+static const unsigned NUM_WG021 = 1;
+static const unsigned NUM_HUBS = 2;
+static const unsigned NUM_SLAVES = NUM_WG05 + NUM_WG06 + NUM_WG021 + NUM_HUBS;
+
+static const double CYCLE_PERIOD = 0.00025;    // 4kHz
+static const double CYCLE_BUDGET_US = 250.0;
+
+// Bytes of each Ethernet frame that are not EtherCAT process data :
+//   preamble (8) + Ethernet header (14) + EtherCAT header (2) +
+//   datagram header (10) + working counter (2) + FCS (4) + inter-frame gap (12)
+static const unsigned FRAME_OVERHEAD = 52;
+static const unsigned MAX_FRAME_DATA = 1486;
+static const double BYTE_TIME_US = 0.08;       // 100Mbit/s
+static const double SLAVE_DELAY_US = 1.0;      // forwarding delay of each slave, both directions plus cable
+// Time for system call, network driver, and interrupt latency for one send/receive
+static const double NETWORK_STACK_US = 60.0;
+
+
+/**
+ * Size of process data for chain, with pressure sensors of grippers enabled
+ */
+static unsigned processDataSize()
+{
+  unsigned size = 0;
+  size += NUM_WG05 * (sizeof(WG0XCommand) + sizeof(WG0XStatus));
+  size += NUM_WG06 * (sizeof(WG0XCommand) + sizeof(WG06StatusWithAccelAndFT) + sizeof(WG06Pressure));
+  size += NUM_WG021 * (sizeof(WG021Command) + sizeof(WG021Status));
+  return size;
+}
+
+
+/**
+ * Wire time for exchanging process data of chain
+ */
+static double wireTimeUs(unsigned size)
+{
+  unsigned frames = (size + MAX_FRAME_DATA - 1) / MAX_FRAME_DATA;
+  return (size + frames * FRAME_OVERHEAD) * BYTE_TIME_US + NUM_SLAVES * SLAVE_DELAY_US;
+}
+
+
+/**
+ * Motor model filters should have same time constant regardless of cycle period
+ */
+TEST(CycleBudget, FilterCoefficientScaling)
+{
+  EXPECT_DOUBLE_EQ(MotorModel::scaleFilterCoefficient(0.2, 0.001), 0.2);
+
+  // Four steps at 4kHz should decay same amount as one step at 1kHz
+  double a = MotorModel::scaleFilterCoefficient(0.2, 0.00025);
+  EXPECT_NEAR(pow(1.0 - a, 4), 0.8, 1e-12);
+
+  MotorModel model(4000, 0.00025);
+  EXPECT_EQ(model.cycles(0.5), 2000);
+  EXPECT_EQ(model.cycles(0.1), 400);
+}
+
+
+/**
+ * Benchmark of CPU work done each cycle by update path for whole chain,
+ * reported against 250us budget together with modeled wire time.
+ */
+TEST(CycleBudget, UpdatePath4kHzBenchmark)
+{
+  static const unsigned CYCLES = 20000;
+
+  srand(1234);
+
+  // Process data buffers laid out as in EthercatHardware
+  unsigned size = processDataSize();
+  std::vector<unsigned char> buffer(size);
+  for (unsigned i=0; i<size; ++i)
+  {
+    buffer[i] = rand();
+  }
+
+  std::vector<MotorModel*> motor_models;
+  for (unsigned i=0; i<NUM_WG05+NUM_WG06; ++i)
+  {
+    motor_models.push_back(new MotorModel(unsigned(1.0/CYCLE_PERIOD), CYCLE_PERIOD));
+  }
+
+  double coeff[36], offsets[6], gains[6];
+  for (unsigned i=0; i<6; ++i)
+  {
+    offsets[i] = 10.0 * i;
+    gains[i] = 30.0;
+    for (unsigned j=0; j<6; ++j)
+    {
+      coeff[i*6+j] = (i==j) ? 2000.0 : 10.0;
+    }
+  }
+  FTCalibration calibration[NUM_WG06];
+  FTFilter filter[NUM_WG06];
+  PressureDecoder pressure[NUM_WG06];
+  for (unsigned g=0; g<NUM_WG06; ++g)
+  {
+    calibration[g].configure(coeff, offsets, gains, 31100);
+    FTFilter::Biquad biquad = FTFilter::lowpass(50.0, sqrt(0.5), 1.0/CYCLE_PERIOD);
+    filter[g].addBiquad(biquad);
+    filter[g].addBiquad(biquad);
+  }
+
+  ethercat_hardware::MotorTraceSample sample;
+  sample.enabled = true;
+  sample.supply_voltage = 24.0;
+  sample.measured_motor_voltage = 1.0;
+  sample.programmed_pwm = 0.1;
+  sample.executed_current = 0.5;
+  sample.measured_current = 0.5;
+  sample.velocity = 1.0;
+  sample.encoder_position = 0.0;
+  sample.encoder_error_count = 0;
+
+  std::vector<double> cycle_times(CYCLES);
+  unsigned checksum = 0;
+  double checkvalue = 0.0;
+
+  for (unsigned cycle=0; cycle<CYCLES; ++cycle)
+  {
+    double start = seconds();
+    unsigned char *p = &buffer[0];
+
+    for (unsigned i=0; i<NUM_WG05+NUM_WG06; ++i)
+    {
+      // pack command, unpack status
+      checksum += wg_util::computeChecksum(p, sizeof(WG0XCommand) - 1);
+      p += sizeof(WG0XCommand);
+      unsigned status_size = (i < NUM_WG05) ? sizeof(WG0XStatus) : sizeof(WG06StatusWithAccelAndFT);
+      checksum += wg_util::computeChecksum(p, status_size);
+
+      sample.encoder_position += 0.001;
+      sample.timestamp = cycle * CYCLE_PERIOD;
+      motor_models[i]->sample(sample);
+      motor_models[i]->verify();
+
+      if (i >= NUM_WG05)
+      {
+        unsigned g = i - NUM_WG05;
+        const WG06StatusWithAccelAndFT *status = (const WG06StatusWithAccelAndFT *)p;
+        double wrenches[4][6];
+        FTSampleErrors errors;
+        calibration[g].convert(status->ft_samples_, 4, wrenches, errors);
+        double out[6];
+        for (unsigned s=0; s<4; ++s)
+        {
+          filter[g].filter(wrenches[s], out);
+        }
+        checkvalue += out[0];
+        p += status_size;
+
+        checksum += wg_util::computeChecksum(p, sizeof(WG06Pressure));
+        pressure[g].decode(p + offsetof(WG06Pressure, l_finger_tip_));
+        checksum += pressure[g].raw(0)[0];
+        p += sizeof(WG06Pressure);
+      }
+      else
+      {
+        p += status_size;
+      }
+    }
+
+    for (unsigned i=0; i<NUM_WG021; ++i)
+    {
+      checksum += wg_util::computeChecksum(p, sizeof(WG021Command) - 1);
+      p += sizeof(WG021Command);
+      checksum += wg_util::computeChecksum(p, sizeof(WG021Status));
+      p += sizeof(WG021Status);
+    }
+
+    cycle_times[cycle] = (seconds() - start) * 1e6;
+  }
+
+  std::sort(cycle_times.begin(), cycle_times.end());
+  double median_us = cycle_times[CYCLES / 2];
+  double p999_us = cycle_times[(CYCLES * 999) / 1000];
+  double wire_us = wireTimeUs(size);
+  double total_us = median_us + wire_us + NETWORK_STACK_US;
+
+  printf("Chain of %u slaves, %u bytes process data\n", NUM_SLAVES, size);
+  printf("  CPU time : median %.1fus, 99.9%% %.1fus\n", median_us, p999_us);
+  printf("  Wire time : %.1fus, network stack allowance : %.1fus\n", wire_us, NETWORK_STACK_US);
+  printf("  Total : %.1fus of %.1fus budget (checksum %u, %g)\n", total_us, CYCLE_BUDGET_US, checksum, checkvalue);
+
+  for (unsigned i=0; i<motor_models.size(); ++i)
+  {
+    delete motor_models[i];
+  }
+}
+
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "ethercat_hardware/cycle_deadline_monitor.h"
+
+using ethercat_hardware::CycleDeadlineMonitor;
+
+static const double PERIOD = 0.001;
+
+
+static void runCycle(CycleDeadlineMonitor &monitor, unsigned cycle, double txandrx)
+{
+  double times[CycleDeadlineMonitor::NUM_PHASES] = {0};
+  times[CycleDeadlineMonitor::PACK] = 20e-6;
+  times[CycleDeadlineMonitor::TXANDRX] = txandrx;
+  times[CycleDeadlineMonitor::UNPACK] = 30e-6;
+  monitor.record(cycle * PERIOD, times);
+}
+
+
+/**
+ * Overruns should be counted per phase, with longest overrun and longest streak
+ */
+TEST(CycleDeadlineMonitor, Overruns)
+{
+  CycleDeadlineMonitor monitor(100);
+  monitor.setDeadline(CycleDeadlineMonitor::TXANDRX, 200e-6);
+  monitor.setDeadline(CycleDeadlineMonitor::UPDATE, PERIOD);
+
+  const double txandrx[] = {100e-6, 250e-6, 300e-6, 100e-6, 220e-6, 100e-6};
+  for (unsigned i=0; i<sizeof(txandrx)/sizeof(txandrx[0]); ++i)
+  {
+    runCycle(monitor, i, txandrx[i]);
+  }
+
+  const CycleDeadlineMonitor::Stats &stats(monitor.stats());
+  EXPECT_EQ(stats.cycles_, 6u);
+  const CycleDeadlineMonitor::PhaseStats &p(stats.phases_[CycleDeadlineMonitor::TXANDRX]);
+  EXPECT_EQ(p.overruns_, 3u);
+  EXPECT_NEAR(p.longest_overrun_, 100e-6, 1e-12);
+  EXPECT_EQ(p.longest_streak_, 2u);
+  EXPECT_EQ(p.streak_, 0u);
+  EXPECT_EQ(stats.phases_[CycleDeadlineMonitor::UPDATE].overruns_, 0u);
+  EXPECT_EQ(stats.phases_[CycleDeadlineMonitor::PACK].overruns_, 0u);
+}
+
+
+/**
+ * Recorder should freeze a few cycles after streak threshold, keep history, and re-arm when capture is taken
+ */
+TEST(CycleDeadlineMonitor, Capture)
+{
+  CycleDeadlineMonitor monitor(10);
+  monitor.setDeadline(CycleDeadlineMonitor::TXANDRX, 200e-6);
+  monitor.setFreezeThresholds(3, 0.0, 2);
+
+  std::vector<CycleDeadlineMonitor::CycleRecord> records;
+  std::string reason;
+  unsigned cycle = 0;
+  for (; cycle<20; ++cycle)
+  {
+    runCycle(monitor, cycle, 100e-6);
+  }
+  EXPECT_FALSE(monitor.takeCapture(records, reason));
+
+  // Three overruns in a row trigger, two more cycles are recorded, then recorder freezes
+  for (unsigned i=0; i<3; ++i, ++cycle)
+  {
+    runCycle(monitor, cycle, 300e-6);
+  }
+  runCycle(monitor, cycle++, 100e-6);
+  EXPECT_FALSE(monitor.takeCapture(records, reason));
+  runCycle(monitor, cycle++, 100e-6);
+  for (unsigned i=0; i<5; ++i, ++cycle)
+  {
+    runCycle(monitor, cycle, 100e-6);
+  }
+  EXPECT_EQ(monitor.stats().captures_, 1u);
+
+  ASSERT_TRUE(monitor.takeCapture(records, reason));
+  ASSERT_EQ(records.size(), 10u);
+  EXPECT_EQ(records.front().cycle_, 15u);
+  EXPECT_EQ(records.back().cycle_, 24u);
+  EXPECT_EQ(records[7].overrun_mask_, 1u << CycleDeadlineMonitor::TXANDRX);
+  EXPECT_NEAR(records[5].times_[CycleDeadlineMonitor::PERIOD], PERIOD, 1e-12);
+  EXPECT_NE(reason.find("Txandrx"), std::string::npos);
+
+  // Re-armed : nothing captured until next trigger
+  EXPECT_FALSE(monitor.takeCapture(records, reason));
+  runCycle(monitor, cycle++, 100e-6);
+  EXPECT_FALSE(monitor.takeCapture(records, reason));
+}
+
+
+/**
+ * Single overrun longer than threshold should trigger capture
+ */
+TEST(CycleDeadlineMonitor, LongOverrun)
+{
+  CycleDeadlineMonitor monitor(10);
+  monitor.setDeadline(CycleDeadlineMonitor::PERIOD, 1.5 * PERIOD);
+  monitor.setFreezeThresholds(0, PERIOD, 0);
+
+  double times[CycleDeadlineMonitor::NUM_PHASES] = {0};
+  monitor.record(0.0, times);
+  monitor.record(PERIOD, times);
+  monitor.record(2.2 * PERIOD, times);  // late, but not by more than threshold
+  std::vector<CycleDeadlineMonitor::CycleRecord> records;
+  std::string reason;
+  EXPECT_FALSE(monitor.takeCapture(records, reason));
+  monitor.record(5.0 * PERIOD, times);  // missed cycles
+  ASSERT_TRUE(monitor.takeCapture(records, reason));
+  EXPECT_EQ(records.size(), 4u);
+  EXPECT_EQ(monitor.stats().phases_[CycleDeadlineMonitor::PERIOD].overruns_, 1u);
+}
+
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <math.h>
+
+#include "ethercat_hardware/encoder_velocity_estimator.h"
+
+using ethercat_hardware::EncoderVelocityEstimator;
+
+
+/**
+ * Samples encoder moving at constant velocity once a millisecond, with quantized count
+ */
+static double runConstant(EncoderVelocityEstimator &estimator, double velocity, unsigned cycles, 
+                          int32_t count_offset = 0, uint32_t timestamp_offset = 0)
+{
+  double v = 0.0;
+  for (unsigned i=0; i<cycles; ++i)
+  {
+    double t = i * 0.001;
+    int32_t count = int32_t(uint32_t(count_offset) + uint32_t(int32_t(floor(velocity * t + 0.3))));
+    uint32_t timestamp = timestamp_offset + i * 1000;
+    v = estimator.update(count, timestamp);
+  }
+  return v;
+}
+
+
+/**
+ * At low speed, two-sample difference is either 0 or 1000 counts/s.  
+ * Estimator should resolve velocity much more finely.
+ */
+TEST(EncoderVelocityEstimator, LowSpeed)
+{
+  const double velocities[] = {75.0, 150.0, -230.0, 400.0, 1200.0};
+  for (unsigned k=0; k<sizeof(velocities)/sizeof(velocities[0]); ++k)
+  {
+    double velocity = velocities[k];
+    EncoderVelocityEstimator estimator(1.0, 0.02);
+    double error = 0.0, two_sample_error = 0.0;
+    int32_t prev_count = 0;
+    for (unsigned i=0; i<300; ++i)
+    {
+      int32_t count = int32_t(floor(velocity * i * 0.001 + 0.3));
+      double v = estimator.update(count, i * 1000);
+      if (i >= 100)
+      {
+        error += fabs(v - velocity);
+        two_sample_error += fabs((count - prev_count) * 1000.0 - velocity);
+      }
+      prev_count = count;
+    }
+    error /= 200;
+    two_sample_error /= 200;
+    EXPECT_LT(error, 0.2 * fabs(velocity)) << "velocity " << velocity;
+    EXPECT_LT(error, 0.2 * two_sample_error) << "velocity " << velocity;
+  }
+}
+
+
+/**
+ * At high speed estimate should be close to true velocity, whatever window is used
+ */
+TEST(EncoderVelocityEstimator, HighSpeed)
+{
+  EncoderVelocityEstimator estimator;
+  double v = runConstant(estimator, 50000.0, 50);
+  EXPECT_NEAR(v, 50000.0, 1000.0);
+}
+
+
+/**
+ * Window should shrink after velocity changes, so estimate follows within a few cycles
+ */
+TEST(EncoderVelocityEstimator, Step)
+{
+  EncoderVelocityEstimator estimator;
+  int32_t count = 0;
+  uint32_t timestamp = 0;
+  for (unsigned i=0; i<50; ++i)
+  {
+    estimator.update(count, timestamp);
+    timestamp += 1000;
+  }
+  EXPECT_EQ(estimator.velocity(), 0.0);
+
+  double v = 0.0;
+  for (unsigned i=0; i<5; ++i)
+  {
+    count += 20;
+    timestamp += 1000;
+    v = estimator.update(count, timestamp);
+  }
+  EXPECT_NEAR(v, 20000.0, 1e-6);
+}
+
+
+/**
+ * Encoder count and device timestamp both wrap around
+ */
+TEST(EncoderVelocityEstimator, WrapAround)
+{
+  EncoderVelocityEstimator estimator;
+  double v = runConstant(estimator, 3000.0, 60, INT32_MAX - 60, UINT32_MAX - 30000);
+  EXPECT_NEAR(v, 3000.0, 100.0);
+}
+
+
+/**
+ * Timestamp going backwards (device reset) should restart history
+ */
+TEST(EncoderVelocityEstimator, TimestampReset)
+{
+  EncoderVelocityEstimator estimator;
+  runConstant(estimator, 1000.0, 30, 0, 1000000);
+  estimator.update(5, 100);
+  EXPECT_EQ(estimator.velocity(), 0.0);
+  EXPECT_EQ(estimator.window(), 0u);
+  estimator.update(7, 1100);
+  EXPECT_NEAR(estimator.velocity(), 2000.0, 1e-6);
+}
+
+
+/**
+ * Repeated timestamp should be ignored, and keep history and estimate
+ */
+TEST(EncoderVelocityEstimator, RepeatedTimestamp)
+{
+  EncoderVelocityEstimator estimator;
+  runConstant(estimator, 1000.0, 30, 0, 1000000);
+  double velocity = estimator.velocity();
+  unsigned window = estimator.window();
+  EXPECT_GT(window, 1u);
+  estimator.update(12345, 1000000 + 29 * 1000);
+  EXPECT_EQ(estimator.velocity(), velocity);
+  EXPECT_EQ(estimator.window(), window);
+  estimator.update(30, 1000000 + 30 * 1000);
+  EXPECT_GT(estimator.window(), 1u);
+  EXPECT_NEAR(estimator.velocity(), 1000.0, 100.0);
+}
+
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "ethercat_hardware/ft_calibration.h"
+#include "test_timing.h"
+
+using ethercat_hardware::FTCalibration;
+using ethercat_hardware::FTSampleErrors;
+
+
+/**
+ * Calibration parameters similar to those of a real gripper F/T sensor
+ */
+class FTCalibrationTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    srand(1234);
+    for (unsigned i=0; i<6; ++i)
+    {
+      offsets_[i] = -200.0 + 40.0 * i;
+      gains_[i] = 30.0 + 2.5 * i;
+      for (unsigned j=0; j<6; ++j)
+      {
+        coeff_[i*6+j] = (i==j) ? 2000.0 : (double(rand() % 2001) - 1000.0) / 10.0;
+      }
+    }
+    limit_ = 31100;
+    calibration_.configure(coeff_, offsets_, gains_, limit_);
+  }
+
+  void randomSample(FTDataSample &sample, int range)
+  {
+    for (unsigned i=0; i<6; ++i)
+    {
+      sample.data_[i] = (rand() % (2*range+1)) - range;
+    }
+    sample.vhalf_ = 32768 + (rand() % 101) - 50;
+    sample.sample_count_ = rand();
+    sample.timestamp_ = rand();
+  }
+
+  /**
+   * Per-sample conversion as it was originally done by WG06:
+   * offset and gain each channel, then multiply by calibration matrix
+   */
+  void referenceConvert(const FTDataSample &sample, double out[6], FTSampleErrors &errors)
+  {
+    double in[6];
+    for (unsigned i=0; i<6; ++i)
+    {
+      int raw_data = sample.data_[i];
+      if (abs(raw_data) > limit_)
+      {
+        errors.overload_flags_ |= (1<<i);
+      }
+      in[i] = (double(raw_data) - offsets_[i]) / ( gains_[i] * double(1<<16) );
+    }
+
+    if ( abs( int(sample.vhalf_) - 32768) > 300 )
+    {
+      if ((sample.vhalf_ == 0x0000) || (sample.vhalf_ == 0xFFFF))
+        errors.disconnected_ = true;
+      else
+        errors.vhalf_error_ = true;
+    }
+
+    for (unsigned i=0; i<6; ++i)
+    {
+      double sum=0.0;
+      for (unsigned j=0; j<6; ++j)
+      {
+        sum += coeff_[i*6+j] * in[j];
+      }
+      out[i] = sum;
+    }
+  }
+
+  void expectSameErrors(const FTSampleErrors &a, const FTSampleErrors &b)
+  {
+    EXPECT_EQ(a.overload_flags_, b.overload_flags_);
+    EXPECT_EQ(a.disconnected_, b.disconnected_);
+    EXPECT_EQ(a.vhalf_error_, b.vhalf_error_);
+  }
+
+  double coeff_[36];
+  double offsets_[6];
+  double gains_[6];
+  int limit_;
+  FTCalibration calibration_;
+};
+
+
+/**
+ * Folded transform and batch conversion should produce same forces as
+ * original per-sample offset/gain/matrix computation.
+ */
+TEST_F(FTCalibrationTest, MatchesReference)
+{
+  static const unsigned N = 4;
+  for (unsigned iter=0; iter<1000; ++iter)
+  {
+    FTDataSample samples[N];
+    for (unsigned s=0; s<N; ++s)
+    {
+      randomSample(samples[s], 32767);
+    }
+
+    double expected[N][6];
+    FTSampleErrors expected_errors;
+    for (unsigned s=0; s<N; ++s)
+    {
+      referenceConvert(samples[s], expected[s], expected_errors);
+    }
+
+    double simd[N][6];
+    double scalar[N][6];
+    FTSampleErrors simd_errors, scalar_errors;
+    calibration_.convert(samples, N, simd, simd_errors);
+    calibration_.convertScalar(samples, N, scalar, scalar_errors);
+
+    for (unsigned s=0; s<N; ++s)
+    {
+      for (unsigned i=0; i<6; ++i)
+      {
+        double tolerance = 1e-12 * (1.0 + fabs(expected[s][i]));
+        EXPECT_NEAR(simd[s][i], expected[s][i], tolerance);
+        EXPECT_NEAR(scalar[s][i], expected[s][i], tolerance);
+      }
+    }
+    expectSameErrors(simd_errors, expected_errors);
+    expectSameErrors(scalar_errors, expected_errors);
+  }
+}
+
+
+/**
+ * Overload flags should be set for each channel beyond limit, including -32768
+ */
+TEST_F(FTCalibrationTest, Overload)
+{
+  FTDataSample samples[2];
+  randomSample(samples[0], 100);
+  randomSample(samples[1], 100);
+  samples[0].data_[1] = limit_;        // at limit : ok
+  samples[0].data_[2] = limit_ + 1;    // overload
+  samples[1].data_[4] = -limit_ - 1;   // overload
+  samples[1].data_[5] = -32768;        // overload
+  samples[1].vhalf_ = 0xFFFF;          // should not leak into overload flags
+
+  double out[2][6];
+  FTSampleErrors errors, scalar_errors;
+  calibration_.convert(samples, 2, out, errors);
+  calibration_.convertScalar(samples, 2, out, scalar_errors);
+  EXPECT_EQ(errors.overload_flags_, (1<<2) | (1<<4) | (1<<5));
+  expectSameErrors(errors, scalar_errors);
+}
+
+
+/**
+ * Vhalf check should distinguish disconnected sensor from bad reference voltage
+ */
+TEST_F(FTCalibrationTest, Vhalf)
+{
+  FTDataSample sample;
+  randomSample(sample, 100);
+  double out[1][6];
+
+  const uint16_t ok_values[] = {32768, 32768-300, 32768+300};
+  for (unsigned i=0; i<sizeof(ok_values)/sizeof(ok_values[0]); ++i)
+  {
+    FTSampleErrors errors;
+    sample.vhalf_ = ok_values[i];
+    calibration_.convert(&sample, 1, out, errors);
+    EXPECT_FALSE(errors.disconnected_);
+    EXPECT_FALSE(errors.vhalf_error_);
+  }
+
+  const uint16_t bad_values[] = {32768-301, 32768+301, 1, 0xFFFE};
+  for (unsigned i=0; i<sizeof(bad_values)/sizeof(bad_values[0]); ++i)
+  {
+    FTSampleErrors errors;
+    sample.vhalf_ = bad_values[i];
+    calibration_.convert(&sample, 1, out, errors);
+    EXPECT_FALSE(errors.disconnected_);
+    EXPECT_TRUE(errors.vhalf_error_);
+  }
+
+  const uint16_t stuck_values[] = {0x0000, 0xFFFF};
+  for (unsigned i=0; i<sizeof(stuck_values)/sizeof(stuck_values[0]); ++i)
+  {
+    FTSampleErrors errors;
+    sample.vhalf_ = stuck_values[i];
+    calibration_.convert(&sample, 1, out, errors);
+    EXPECT_TRUE(errors.disconnected_);
+    EXPECT_FALSE(errors.vhalf_error_);
+  }
+}
+
+
+/**
+ * Benchmark batch conversion against original per-sample computation.
+ */
+TEST_F(FTCalibrationTest, Benchmark)
+{
+  static const unsigned N = 4;
+  static const unsigned NUM_SETS = 64;
+  static const unsigned ITERATIONS = 200000;
+
+  FTDataSample samples[NUM_SETS][N];
+  for (unsigned k=0; k<NUM_SETS; ++k)
+  {
+    for (unsigned s=0; s<N; ++s)
+    {
+      randomSample(samples[k][s], 31000);
+    }
+  }
+
+  double out[N][6];
+  double checksum = 0.0;
+  FTSampleErrors errors;
+
+  double start = seconds();
+  for (unsigned iter=0; iter<ITERATIONS; ++iter)
+  {
+    const FTDataSample *set = samples[iter % NUM_SETS];
+    for (unsigned s=0; s<N; ++s)
+    {
+      referenceConvert(set[s], out[s], errors);
+    }
+    checksum += out[iter % N][iter % 6];
+  }
+  double reference_time = seconds() - start;
+
+  start = seconds();
+  for (unsigned iter=0; iter<ITERATIONS; ++iter)
+  {
+    calibration_.convertScalar(samples[iter % NUM_SETS], N, out, errors);
+    checksum += out[iter % N][iter % 6];
+  }
+  double scalar_time = seconds() - start;
+
+  start = seconds();
+  for (unsigned iter=0; iter<ITERATIONS; ++iter)
+  {
+    calibration_.convert(samples[iter % NUM_SETS], N, out, errors);
+    checksum += out[iter % N][iter % 6];
+  }
+  double batch_time = seconds() - start;
+
+  double scale = 1e9 / ITERATIONS;
+  printf("F/T conversion of %d samples : reference %.1fns, folded %.1fns, batch %.1fns (checksum %g)\n",
+         N, reference_time * scale, scalar_time * scale, batch_time * scale, checksum);
+  EXPECT_TRUE(checksum == checksum);
+}
+
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
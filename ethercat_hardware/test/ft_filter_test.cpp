@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include <algorithm>
+
+#include "ethercat_hardware/ft_filter.h"
+
+using ethercat_hardware::FTFilter;
+
+
+static void fill(double value[6], double v)
+{
+  for (unsigned ch=0; ch<6; ++ch)
+  {
+    value[ch] = v * (ch+1);
+  }
+}
+
+
+/**
+ * With no stages configured, filter should pass input through unchanged
+ */
+TEST(FTFilter, Passthrough)
+{
+  FTFilter filter;
+  double in[6], out[6];
+  for (unsigned i=0; i<10; ++i)
+  {
+    fill(in, 0.5*i);
+    ASSERT_TRUE(filter.filter(in, out));
+    for (unsigned ch=0; ch<6; ++ch)
+    {
+      EXPECT_DOUBLE_EQ(out[ch], in[ch]);
+    }
+  }
+}
+
+
+/**
+ * Low-pass filter should start at steady state for first sample (no step transient),
+ * pass DC, and attenuate signal near Nyquist frequency.
+ */
+TEST(FTFilter, Lowpass)
+{
+  FTFilter filter;
+  FTFilter::Biquad biquad = FTFilter::lowpass(20.0, sqrt(0.5), 1000.0);
+  ASSERT_TRUE(filter.addBiquad(biquad));
+  ASSERT_TRUE(filter.addBiquad(biquad));
+
+  double in[6], out[6];
+  fill(in, 3.0);
+  for (unsigned i=0; i<100; ++i)
+  {
+    ASSERT_TRUE(filter.filter(in, out));
+    for (unsigned ch=0; ch<6; ++ch)
+    {
+      EXPECT_NEAR(out[ch], in[ch], 1e-9);
+    }
+  }
+
+  // Alternating +/- signal at half sample rate
+  double max_out = 0.0;
+  for (unsigned i=0; i<1000; ++i)
+  {
+    fill(in, (i&1) ? 1.0 : -1.0);
+    filter.filter(in, out);
+    if (i > 500)
+      max_out = std::max(max_out, fabs(out[0]));
+  }
+  EXPECT_LT(max_out, 1e-3);
+}
+
+
+/**
+ * Decimator should produce one averaged output for every N inputs
+ */
+TEST(FTFilter, Decimation)
+{
+  FTFilter filter;
+  filter.setDecimation(4);
+
+  double in[6], out[6];
+  unsigned outputs = 0;
+  for (unsigned i=0; i<16; ++i)
+  {
+    fill(in, i);
+    if (filter.filter(in, out))
+    {
+      ++outputs;
+      // Average of i-3 .. i
+      EXPECT_DOUBLE_EQ(out[0], i - 1.5);
+      EXPECT_DOUBLE_EQ(out[5], 6.0 * (i - 1.5));
+    }
+  }
+  EXPECT_EQ(outputs, 4u);
+}
+
+
+/**
+ * Tare should estimate bias over given number of samples, then remove it from output
+ */
+TEST(FTFilter, Tare)
+{
+  FTFilter filter;
+  filter.setTareSamples(10);
+
+  double in[6], out[6];
+  fill(in, 2.0);
+  filter.tare();
+  for (unsigned i=0; i<9; ++i)
+  {
+    EXPECT_TRUE(filter.isTaring());
+    filter.filter(in, out);
+    EXPECT_DOUBLE_EQ(out[1], in[1]);
+  }
+  filter.filter(in, out);
+  EXPECT_FALSE(filter.isTaring());
+  for (unsigned ch=0; ch<6; ++ch)
+  {
+    EXPECT_DOUBLE_EQ(filter.bias()[ch], in[ch]);
+    EXPECT_DOUBLE_EQ(out[ch], 0.0);
+  }
+
+  fill(in, 3.0);
+  filter.filter(in, out);
+  EXPECT_DOUBLE_EQ(out[0], 1.0);
+}
+
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
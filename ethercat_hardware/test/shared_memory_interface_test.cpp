@@ -0,0 +1,328 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "ethercat_hardware/shared_memory_interface.h"
+
+using namespace ethercat_hardware;
+
+
+//! Gives test access to driver side sequence counter
+class TestMirror : public SharedMemoryMirror
+{
+public:
+  SharedMemoryHeader *header() {return header_;}
+};
+
+//! Gives test access to controller side sequence counter
+class TestClient : public SharedMemoryClient
+{
+public:
+  SharedMemoryHeader *header() {return header_;}
+};
+
+
+class SharedMemoryTest : public testing::Test
+{
+protected:
+  static const double CYCLE_PERIOD;
+  static const double COMMAND_TIMEOUT;  // 5 cycles
+
+  pr2_hardware_interface::HardwareInterface hw_;
+  pr2_hardware_interface::Actuator a_, b_;
+  TestMirror mirror_;
+  TestClient client_;
+  std::string name_;
+
+  void SetUp()
+  {
+    a_.name_ = "a_motor";
+    b_.name_ = "b_motor";
+    initActuator(a_);
+    initActuator(b_);
+    hw_.actuators_[a_.name_] = &a_;
+    hw_.actuators_[b_.name_] = &b_;
+
+    char name[64];
+    snprintf(name, sizeof(name), "/ethercat_hardware_test_%d", int(getpid()));
+    name_ = name;
+    ASSERT_TRUE(mirror_.initialize(name_, &hw_, CYCLE_PERIOD, COMMAND_TIMEOUT));
+    ASSERT_TRUE(client_.attach(name_));
+  }
+
+  static void initActuator(pr2_hardware_interface::Actuator &actuator)
+  {
+    pr2_hardware_interface::ActuatorState &state(actuator.state_);
+    state.timestamp_ = 0.0;
+    state.sample_timestamp_.sec = 0;
+    state.sample_timestamp_.nsec = 0;
+    state.position_ = 0.0;
+    state.velocity_ = 0.0;
+    state.last_measured_effort_ = 0.0;
+    state.last_commanded_effort_ = 0.0;
+    state.max_effort_ = 0.0;
+    state.last_calibration_rising_edge_ = 0.0;
+    state.last_calibration_falling_edge_ = 0.0;
+    state.zero_offset_ = 0.0;
+    state.encoder_count_ = 0;
+    state.is_enabled_ = false;
+    state.halted_ = false;
+    state.calibration_reading_ = false;
+    state.calibration_rising_edge_valid_ = false;
+    state.calibration_falling_edge_valid_ = false;
+    actuator.command_.enable_ = false;
+    actuator.command_.effort_ = 0.0;
+  }
+
+  //! Command of in-process controller, that shared memory must not override unless claimed
+  static void setLocalCommand(pr2_hardware_interface::Actuator &actuator, double effort)
+  {
+    actuator.command_.enable_ = true;
+    actuator.command_.effort_ = effort;
+  }
+
+  std::vector<SharedActuatorCommand> commands(double effort_a, bool claim_a, double effort_b, bool claim_b)
+  {
+    std::vector<SharedActuatorCommand> commands(client_.numActuators());
+    memset(&commands[0], 0, commands.size() * sizeof(SharedActuatorCommand));
+    int a = client_.actuatorIndex(a_.name_);
+    int b = client_.actuatorIndex(b_.name_);
+    commands[a].effort_ = effort_a;
+    commands[a].enable_ = true;
+    commands[a].claimed_ = claim_a;
+    commands[b].effort_ = effort_b;
+    commands[b].enable_ = true;
+    commands[b].claimed_ = claim_b;
+    return commands;
+  }
+};
+
+const double SharedMemoryTest::CYCLE_PERIOD = 0.001;
+const double SharedMemoryTest::COMMAND_TIMEOUT = 0.005;
+
+
+TEST_F(SharedMemoryTest, Attach)
+{
+  ASSERT_EQ(client_.numActuators(), 2u);
+  EXPECT_GE(client_.actuatorIndex(a_.name_), 0);
+  EXPECT_GE(client_.actuatorIndex(b_.name_), 0);
+  EXPECT_EQ(client_.actuatorIndex("no_motor"), -1);
+  EXPECT_EQ(client_.actuatorName(client_.actuatorIndex(b_.name_)), b_.name_);
+
+  TestClient other;
+  EXPECT_FALSE(other.attach(name_ + "_missing"));
+}
+
+
+/**
+ * Every state field, including calibration data, should reach client unchanged
+ */
+TEST_F(SharedMemoryTest, StateRoundTrip)
+{
+  pr2_hardware_interface::ActuatorState &state(a_.state_);
+  state.timestamp_ = 12.5;
+  state.sample_timestamp_.sec = 12;
+  state.sample_timestamp_.nsec = 500000000;
+  state.position_ = 1.25;
+  state.velocity_ = -0.5;
+  state.last_measured_effort_ = 2.0;
+  state.last_commanded_effort_ = 2.5;
+  state.max_effort_ = 10.0;
+  state.last_calibration_rising_edge_ = 0.75;
+  state.last_calibration_falling_edge_ = 0.625;
+  state.zero_offset_ = 0.125;
+  state.encoder_count_ = -123456;
+  state.is_enabled_ = true;
+  state.halted_ = true;
+  state.calibration_reading_ = true;
+  state.calibration_rising_edge_valid_ = true;
+  state.calibration_falling_edge_valid_ = false;
+
+  mirror_.writeState();
+
+  std::vector<SharedActuatorState> states;
+  uint64_t cycle = 0;
+  ASSERT_TRUE(client_.readState(states, cycle));
+  EXPECT_EQ(cycle, 1u);
+  ASSERT_EQ(states.size(), 2u);
+  const SharedActuatorState &s(states[client_.actuatorIndex(a_.name_)]);
+  EXPECT_EQ(s.timestamp_, 12.5);
+  EXPECT_EQ(s.sample_timestamp_sec_, 12);
+  EXPECT_EQ(s.sample_timestamp_nsec_, 500000000);
+  EXPECT_EQ(s.position_, 1.25);
+  EXPECT_EQ(s.velocity_, -0.5);
+  EXPECT_EQ(s.last_measured_effort_, 2.0);
+  EXPECT_EQ(s.last_commanded_effort_, 2.5);
+  EXPECT_EQ(s.max_effort_, 10.0);
+  EXPECT_EQ(s.last_calibration_rising_edge_, 0.75);
+  EXPECT_EQ(s.last_calibration_falling_edge_, 0.625);
+  EXPECT_EQ(s.zero_offset_, 0.125);
+  EXPECT_EQ(s.encoder_count_, -123456);
+  EXPECT_TRUE(s.is_enabled_);
+  EXPECT_TRUE(s.halted_);
+  EXPECT_TRUE(s.calibration_reading_);
+  EXPECT_TRUE(s.calibration_rising_edge_valid_);
+  EXPECT_FALSE(s.calibration_falling_edge_valid_);
+
+  mirror_.writeState();
+  ASSERT_TRUE(client_.readState(states, cycle));
+  EXPECT_EQ(cycle, 2u);
+}
+
+
+/**
+ * Client should not read state while driver is in the middle of writing it
+ */
+TEST_F(SharedMemoryTest, StateWriteInProgress)
+{
+  mirror_.writeState();
+  std::vector<SharedActuatorState> states;
+  uint64_t cycle;
+  ASSERT_TRUE(client_.readState(states, cycle));
+
+  mirror_.header()->state_sequence_.fetch_add(1);
+  EXPECT_FALSE(client_.readState(states, cycle));
+  mirror_.header()->state_sequence_.fetch_add(1);
+  EXPECT_TRUE(client_.readState(states, cycle));
+}
+
+
+/**
+ * Without a controller process, in-process commands must be left alone
+ */
+TEST_F(SharedMemoryTest, NoClientKeepsLocalCommands)
+{
+  for (unsigned i=0; i<20; ++i)
+  {
+    setLocalCommand(a_, 1.0);
+    setLocalCommand(b_, 2.0);
+    mirror_.readCommands();
+    mirror_.writeState();
+    EXPECT_TRUE(a_.command_.enable_);
+    EXPECT_EQ(a_.command_.effort_, 1.0);
+    EXPECT_TRUE(b_.command_.enable_);
+    EXPECT_EQ(b_.command_.effort_, 2.0);
+  }
+  EXPECT_EQ(mirror_.staleCycles(), 0u);
+}
+
+
+/**
+ * Only claimed actuators take commands from shared memory
+ */
+TEST_F(SharedMemoryTest, ClaimedCommands)
+{
+  mirror_.writeState();
+  client_.writeCommands(commands(5.0, false, -3.0, true), 1);
+
+  mirror_.writeState();
+  setLocalCommand(a_, 1.0);
+  setLocalCommand(b_, 2.0);
+  mirror_.readCommands();
+  EXPECT_TRUE(a_.command_.enable_);
+  EXPECT_EQ(a_.command_.effort_, 1.0);
+  EXPECT_TRUE(b_.command_.enable_);
+  EXPECT_EQ(b_.command_.effort_, -3.0);
+  EXPECT_EQ(mirror_.latencyCycles(), 1u);
+  EXPECT_EQ(client_.latencyCycles(), 1u);
+}
+
+
+/**
+ * Zero offset written by calibration controller in other process reaches actuator state
+ */
+TEST_F(SharedMemoryTest, ZeroOffset)
+{
+  std::vector<SharedActuatorCommand> cmds(commands(0.0, true, 0.0, false));
+  int a = client_.actuatorIndex(a_.name_);
+  int b = client_.actuatorIndex(b_.name_);
+  cmds[a].zero_offset_ = 0.5;
+  cmds[a].set_zero_offset_ = true;
+  cmds[b].zero_offset_ = 0.25;
+  cmds[b].set_zero_offset_ = true;   // ignored, not claimed
+  client_.writeCommands(cmds, 0);
+  mirror_.readCommands();
+  EXPECT_EQ(a_.state_.zero_offset_, 0.5);
+  EXPECT_EQ(b_.state_.zero_offset_, 0.0);
+
+  mirror_.writeState();
+  std::vector<SharedActuatorState> states;
+  uint64_t cycle;
+  ASSERT_TRUE(client_.readState(states, cycle));
+  EXPECT_EQ(states[a].zero_offset_, 0.5);
+}
+
+
+/**
+ * While client is writing, driver should keep using previous complete commands
+ */
+TEST_F(SharedMemoryTest, CommandWriteInProgress)
+{
+  client_.writeCommands(commands(1.0, true, 2.0, true), 0);
+  mirror_.readCommands();
+  EXPECT_EQ(a_.command_.effort_, 1.0);
+  EXPECT_EQ(mirror_.tornReads(), 0u);
+
+  // Client is interrupted halfway through writing new commands
+  std::vector<SharedActuatorCommand> cmds(commands(7.0, true, 8.0, true));
+  SharedMemoryHeader *header = client_.header();
+  header->command_sequence_.fetch_add(1);
+  SharedActuatorCommand *shared = (SharedActuatorCommand *)((char *)header + sizeof(SharedMemoryHeader) + 
+                                                            client_.numActuators() * sizeof(SharedActuatorState));
+  shared[client_.actuatorIndex(a_.name_)] = cmds[client_.actuatorIndex(a_.name_)];
+
+  mirror_.readCommands();
+  EXPECT_EQ(a_.command_.effort_, 1.0);
+  EXPECT_EQ(b_.command_.effort_, 2.0);
+  EXPECT_EQ(mirror_.tornReads(), 1u);
+
+  header->command_sequence_.fetch_add(1);
+  mirror_.readCommands();
+  EXPECT_EQ(a_.command_.effort_, 7.0);
+}
+
+
+/**
+ * Claimed actuators are disabled when client stops updating commands, and enabled again 
+ * when fresh commands arrive.  Unclaimed actuators are not affected.
+ */
+TEST_F(SharedMemoryTest, StaleCommands)
+{
+  client_.writeCommands(commands(1.0, true, 0.0, false), 0);
+  for (unsigned i=0; i<5; ++i)
+  {
+    mirror_.writeState();
+    setLocalCommand(b_, 2.0);
+    mirror_.readCommands();
+    EXPECT_TRUE(a_.command_.enable_);
+  }
+
+  mirror_.writeState();
+  setLocalCommand(b_, 2.0);
+  mirror_.readCommands();
+  EXPECT_FALSE(a_.command_.enable_);
+  EXPECT_EQ(a_.command_.effort_, 0.0);
+  EXPECT_TRUE(b_.command_.enable_);
+  EXPECT_EQ(b_.command_.effort_, 2.0);
+  EXPECT_EQ(mirror_.staleCycles(), 1u);
+  EXPECT_EQ(mirror_.maxLatencyCycles(), 6u);
+
+  std::vector<SharedActuatorState> states;
+  uint64_t cycle;
+  ASSERT_TRUE(client_.readState(states, cycle));
+  client_.writeCommands(commands(1.5, true, 0.0, false), cycle);
+  mirror_.readCommands();
+  EXPECT_TRUE(a_.command_.enable_);
+  EXPECT_EQ(a_.command_.effort_, 1.5);
+}
+
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,17 @@
+#ifndef ETHERCAT_HARDWARE__TEST_TIMING_H
+#define ETHERCAT_HARDWARE__TEST_TIMING_H
+
+#include <time.h>
+
+/*!
+ * \brief Monotonic time in seconds, for benchmarks in tests.
+ * Benchmarks report timing, but do not check it, since it depends on machine load.
+ */
+static inline double seconds()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+#endif /* ETHERCAT_HARDWARE__TEST_TIMING_H */
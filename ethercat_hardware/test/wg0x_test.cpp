@@ -2,6 +2,12 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include "test_timing.h"
 
 /** 
  * Make sure WG0X::timestampDiff funtion should handle wrap around
@@ -159,6 +165,142 @@ TEST(WG0X, calcEncoderVelocity)
 
 
 
+/**
+ * Per-cycle conversion WG0X::unpackState used before conversion plans were precomputed.
+ */
+static void convertDirect(const WG0XStatus &status, const WG0XActuatorInfo &actuator_info, 
+                          const WG0XConfigInfo &config_info, double max_current,
+                          pr2_hardware_interface::ActuatorState &state)
+{
+  state.position_ = double(status.encoder_count_) / actuator_info.pulses_per_revolution_ * 2 * M_PI - state.zero_offset_;
+  state.last_calibration_rising_edge_ = double(status.last_calibration_rising_edge_) / actuator_info.pulses_per_revolution_ * 2 * M_PI;
+  state.last_calibration_falling_edge_ = double(status.last_calibration_falling_edge_) / actuator_info.pulses_per_revolution_ * 2 * M_PI;
+  state.last_executed_current_ = status.programmed_current_ * config_info.nominal_current_scale_;
+  state.last_measured_current_ = status.measured_current_ * config_info.nominal_current_scale_;
+  state.last_executed_effort_ = status.programmed_current_ * config_info.nominal_current_scale_ * actuator_info.motor_torque_constant_ * actuator_info.encoder_reduction_;
+  state.last_measured_effort_ = status.measured_current_ * config_info.nominal_current_scale_ * actuator_info.motor_torque_constant_ * actuator_info.encoder_reduction_;
+  state.motor_voltage_ = status.motor_voltage_ * config_info.nominal_voltage_scale_;
+  state.max_effort_ = max_current * actuator_info.encoder_reduction_ * actuator_info.motor_torque_constant_; 
+}
+
+
+static void setupConversion(WG0XActuatorInfo &actuator_info, WG0XConfigInfo &config_info)
+{
+  memset(&actuator_info, 0, sizeof(actuator_info));
+  memset(&config_info, 0, sizeof(config_info));
+  actuator_info.pulses_per_revolution_ = 1200;
+  actuator_info.motor_torque_constant_ = 0.0603;
+  actuator_info.encoder_reduction_ = -47.5;
+  config_info.nominal_current_scale_ = 0.00081;
+  config_info.nominal_voltage_scale_ = 0.0011;
+}
+
+
+static void randomStatus(WG0XStatus &status)
+{
+  memset(&status, 0, sizeof(status));
+  status.encoder_count_ = (rand() << 1) ^ rand();
+  status.last_calibration_rising_edge_ = (rand() << 1) ^ rand();
+  status.last_calibration_falling_edge_ = (rand() << 1) ^ rand();
+  status.programmed_current_ = rand();
+  status.measured_current_ = rand();
+  status.motor_voltage_ = rand();
+}
+
+
+static void expectNear(double expected, double actual)
+{
+  EXPECT_NEAR(expected, actual, 1e-12 * std::max(1.0, fabs(expected)));
+}
+
+
+/**
+ * Precomputed conversion should match per-cycle conversion to within rounding.
+ */
+TEST(WG0X, conversionPlanMatchesDirect)
+{
+  WG0XActuatorInfo actuator_info;
+  WG0XConfigInfo config_info;
+  setupConversion(actuator_info, config_info);
+  double max_current = 7.0;
+
+  WG0XConversionPlan plan;
+  plan.build(actuator_info, config_info, max_current);
+
+  srand(1);
+  for (unsigned i=0; i<10000; ++i)
+  {
+    WG0XStatus status;
+    randomStatus(status);
+    pr2_hardware_interface::ActuatorState expected, actual;
+    expected.zero_offset_ = actual.zero_offset_ = 0.25;
+    convertDirect(status, actuator_info, config_info, max_current, expected);
+    plan.convert(status, actual);
+    expectNear(expected.position_, actual.position_);
+    expectNear(expected.last_calibration_rising_edge_, actual.last_calibration_rising_edge_);
+    expectNear(expected.last_calibration_falling_edge_, actual.last_calibration_falling_edge_);
+    EXPECT_EQ(expected.last_executed_current_, actual.last_executed_current_);
+    EXPECT_EQ(expected.last_measured_current_, actual.last_measured_current_);
+    expectNear(expected.last_executed_effort_, actual.last_executed_effort_);
+    expectNear(expected.last_measured_effort_, actual.last_measured_effort_);
+    EXPECT_EQ(expected.motor_voltage_, actual.motor_voltage_);
+    expectNear(expected.max_effort_, actual.max_effort_);
+  }
+}
+
+
+/**
+ * Benchmark precomputed conversion against per-cycle conversion.
+ */
+TEST(WG0X, conversionPlanBenchmark)
+{
+  static const unsigned NUM_STATUS = 64;
+  static const unsigned ITERATIONS = 20000;
+
+  WG0XActuatorInfo actuator_info;
+  WG0XConfigInfo config_info;
+  setupConversion(actuator_info, config_info);
+  double max_current = 7.0;
+
+  WG0XConversionPlan plan;
+  plan.build(actuator_info, config_info, max_current);
+
+  std::vector<WG0XStatus> status(NUM_STATUS);
+  for (unsigned i=0; i<NUM_STATUS; ++i)
+  {
+    randomStatus(status[i]);
+  }
+
+  pr2_hardware_interface::ActuatorState state;
+  double sum = 0.0;
+
+  double start = seconds();
+  for (unsigned iter=0; iter<ITERATIONS; ++iter)
+  {
+    for (unsigned i=0; i<NUM_STATUS; ++i)
+    {
+      convertDirect(status[i], actuator_info, config_info, max_current, state);
+      sum += state.position_ + state.last_measured_effort_;
+    }
+  }
+  double direct_time = seconds() - start;
+
+  start = seconds();
+  for (unsigned iter=0; iter<ITERATIONS; ++iter)
+  {
+    for (unsigned i=0; i<NUM_STATUS; ++i)
+    {
+      plan.convert(status[i], state);
+      sum += state.position_ + state.last_measured_effort_;
+    }
+  }
+  double plan_time = seconds() - start;
+
+  double scale = 1e9 / (double(ITERATIONS) * NUM_STATUS);
+  printf("Status conversion : per-cycle %.1fns, precomputed %.1fns\n", direct_time * scale, plan_time * scale);
+  printf("(sum %f)\n", sum);
+}
+
 // Run all the tests that were declared with TEST()
 int main(int argc, char **argv)
 {
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "ethercat_hardware/wg_util.h"
+#include "ethercat_hardware/wg0x.h"
+#include "test_timing.h"
+
+using namespace ethercat_hardware;
+
+
+/**
+ * Checksum is linear over XOR, so checking every byte value at every position 
+ * (from every alignment) covers every possible buffer of these lengths.
+ */
+TEST(WGUtil, ChecksumEveryByteValue)
+{
+  static const unsigned MAX_LENGTH = 40;
+  unsigned char buffer[MAX_LENGTH + 8];
+  for (unsigned align=0; align<8; ++align)
+  {
+    for (unsigned length=0; length<=MAX_LENGTH; ++length)
+    {
+      unsigned char *data = buffer + align;
+      memset(buffer, 0, sizeof(buffer));
+      ASSERT_EQ(wg_util::computeChecksum(data, length), wg_util::computeChecksumBytewise(data, length));
+      for (unsigned pos=0; pos<length; ++pos)
+      {
+        for (unsigned value=1; value<256; ++value)
+        {
+          data[pos] = value;
+          ASSERT_EQ(wg_util::computeChecksum(data, length), wg_util::computeChecksumBytewise(data, length))
+            << "align " << align << ", length " << length << ", position " << pos << ", value " << value;
+        }
+        data[pos] = 0;
+      }
+    }
+  }
+}
+
+
+/**
+ * Random buffers up to size of largest WG06 pressure block and mailbox
+ */
+TEST(WGUtil, ChecksumRandom)
+{
+  srand(1234);
+  std::vector<unsigned char> buffer(1024 + 8);
+  for (unsigned iter=0; iter<20000; ++iter)
+  {
+    unsigned length = rand() % 1025;
+    unsigned align = rand() % 8;
+    for (unsigned i=0; i<length; ++i)
+    {
+      buffer[align+i] = rand();
+    }
+    ASSERT_EQ(wg_util::computeChecksum(&buffer[align], length), 
+              wg_util::computeChecksumBytewise(&buffer[align], length));
+  }
+}
+
+
+/**
+ * Benchmark checksum against byte loop for sizes of WG0X command, status, and WG06 pressure data.
+ */
+TEST(WGUtil, ChecksumBenchmark)
+{
+  static const unsigned ITERATIONS = 200000;
+  const unsigned sizes[] = {sizeof(WG0XCommand)-1, sizeof(WG0XStatus), 132, 513};
+
+  std::vector<unsigned char> buffer(1024);
+  for (unsigned i=0; i<buffer.size(); ++i)
+  {
+    buffer[i] = rand();
+  }
+
+  unsigned checksum = 0;
+  for (unsigned k=0; k<sizeof(sizes)/sizeof(sizes[0]); ++k)
+  {
+    unsigned size = sizes[k];
+    double start = seconds();
+    for (unsigned iter=0; iter<ITERATIONS; ++iter)
+    {
+      checksum += wg_util::computeChecksumBytewise(&buffer[iter % 8], size);
+    }
+    double bytewise_time = seconds() - start;
+
+    start = seconds();
+    for (unsigned iter=0; iter<ITERATIONS; ++iter)
+    {
+      checksum += wg_util::computeChecksum(&buffer[iter % 8], size);
+    }
+    double word_time = seconds() - start;
+
+    double scale = 1e9 / ITERATIONS;
+    printf("Checksum of %u bytes : byte loop %.1fns, word-at-a-time %.1fns\n", 
+           size, bytewise_time * scale, word_time * scale);
+  }
+  printf("(checksum %u)\n", checksum);
+}
+
+
+// Run all the tests that were declared with TEST()
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}